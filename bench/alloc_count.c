@@ -0,0 +1,45 @@
+/*
+ * Preloadable shim that counts heap allocation calls (malloc, calloc and realloc)
+ * made by a process and writes the total to the file named by ALLOC_COUNT_FILE
+ * when the process exits. Relies on glibc's __libc_* entry points.
+ *
+ * Build: cc -shared -fPIC -O2 bench/alloc_count.c -o alloc_count.so
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocation_calls;
+
+void *malloc(size_t size) {
+    allocation_calls++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    allocation_calls++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocation_calls++;
+    return __libc_realloc(ptr, size);
+}
+
+static void report_allocations(void) __attribute__((destructor));
+
+static void report_allocations(void) {
+    unsigned long total = allocation_calls;
+    const char *path = getenv("ALLOC_COUNT_FILE");
+    FILE *file;
+
+    if (path != NULL && (file = fopen(path, "w")) != NULL) {
+        fprintf(file, "%lu\n", total);
+        fclose(file);
+    }
+}
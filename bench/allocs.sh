@@ -0,0 +1,38 @@
+#!/bin/sh
+# Counts heap allocation calls per assembled line.
+# Each generated source line declares a label and references it from an
+# instruction, so it exercises label creation and label-carrying words. The
+# per-line figure is the difference between two sizes divided by the number of
+# extra lines, which cancels out fixed start-up allocations.
+#
+# Usage: bench/allocs.sh [assembler binary] [lines]
+
+BIN=${1:-./assembler}
+LINES=${2:-10000}
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORKDIR=$(mktemp -d)
+BIN=$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")
+
+trap 'rm -rf "$WORKDIR"' EXIT
+
+cc -shared -fPIC -O2 "$HERE/alloc_count.c" -o "$WORKDIR/alloc_count.so" || exit 1
+
+count_allocations() {
+    awk -v n="$1" 'BEGIN {
+        for (i = 0; i < n; i++) {
+            printf "L%d: mov L%d, r%d\n", i, i, 1 + i % 7
+        }
+        print "stop"
+    }' > "$WORKDIR/bench.as"
+    (cd "$WORKDIR" && ALLOC_COUNT_FILE="$WORKDIR/count" LD_PRELOAD="$WORKDIR/alloc_count.so" \
+        "$BIN" bench > /dev/null 2>&1)
+    cat "$WORKDIR/count"
+}
+
+small=$(count_allocations "$LINES")
+large=$(count_allocations $((LINES * 2)))
+
+printf "%10s %14s %14s %12s\n" "lines" "allocations" "allocations" "per line"
+awk -v n="$LINES" -v a="$small" -v b="$large" 'BEGIN {
+    printf "%10d %14d %14d %12.3f\n", n, a, b, (b - a) / n
+}'
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Compares two results files written by bench/run.sh, row by row.
+# Counters are reported on any change; stage times and peak memory only when they
+# move by more than THRESHOLD percent (default 10), as they vary between runs.
+#
+# Usage: bench/compare.sh <baseline file> <results file>
+
+THRESHOLD=${THRESHOLD:-10}
+
+if [ $# -ne 2 ]; then
+    sed -n '2,/^$/s/^# \{0,1\}//p' "$0" >&2
+    exit 1
+fi
+
+awk -F, -v threshold="$THRESHOLD" '
+    FNR == 1 {
+        for (i = 1; i <= NF; i++) column[FILENAME, i] = $i
+        columns[FILENAME] = NF
+        next
+    }
+    FILENAME == ARGV[1] {
+        for (i = 3; i <= NF; i++) baseline[$1 "," $2, column[FILENAME, i]] = $i
+        next
+    }
+    {
+        row = $1 "," $2
+        for (i = 3; i <= NF; i++) {
+            name = column[FILENAME, i]
+            if (!((row, name) in baseline)) {
+                continue
+            }
+            old = baseline[row, name] + 0
+            new = $i + 0
+            change = old != 0 ? (new - old) * 100 / old : (new != 0 ? 100 : 0)
+            timed = name ~ /_(ms|kb)$/
+            if ((timed && (change > threshold || change < -threshold)) || (!timed && new != old)) {
+                if (!changes++) printf "%10s %6s %-24s %14s %14s %9s\n", "body_lines", "files", "column", "baseline", "current", "change"
+                printf "%10s %6s %-24s %14s %14s %+8.1f%%\n", $1, $2, name, baseline[row, name], $i, change
+            }
+        }
+    }
+    END {
+        if (!changes) printf "No changes against the baseline (times and memory within %s%%)\n", threshold
+    }' "$1" "$2"
@@ -0,0 +1,131 @@
+#!/bin/sh
+# Generates valid assembly sources for performance work.
+# Every file starts with its macro definitions and then has LINES body lines, each an
+# instruction, a .data/.string directive or a macro use, with a LABELS percent chance
+# of being labelled. Instructions reference labels of the same file and, with several
+# files, the exported labels of the next file through .extern, since the assembler
+# resolves externs among the files it is given, declared before they are defined. A few labels are declared .entry.
+# The same arguments always produce the same files. Sources beyond the 4096-word
+# memory still assemble, with overflow warnings.
+#
+# Usage: bench/generate.sh [options] <output directory>
+#   -f FILES   number of files (default 1)
+#   -l LINES   body lines per file (default 1000)
+#   -L PERCENT share of labelled lines (default 20)
+#   -m MACROS  macros per file (default 4)
+#   -s SIZE    lines per macro (default 4)
+#   -d PERCENT share of directive lines (default 30)
+#   -r SEED    random seed (default 1)
+#   -p PREFIX  file name prefix (default gen)
+
+FILES=1
+LINES=1000
+LABELS=20
+MACROS=4
+MACRO_SIZE=4
+DIRECTIVES=30
+SEED=1
+PREFIX=gen
+
+while getopts "f:l:L:m:s:d:r:p:" option; do
+    case $option in
+        f) FILES=$OPTARG ;;
+        l) LINES=$OPTARG ;;
+        L) LABELS=$OPTARG ;;
+        m) MACROS=$OPTARG ;;
+        s) MACRO_SIZE=$OPTARG ;;
+        d) DIRECTIVES=$OPTARG ;;
+        r) SEED=$OPTARG ;;
+        p) PREFIX=$OPTARG ;;
+        *) sed -n '2,/^$/s/^# \{0,1\}//p' "$0" >&2; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 1 ]; then
+    sed -n '2,/^$/s/^# \{0,1\}//p' "$0" >&2
+    exit 1
+fi
+OUTDIR=$1
+mkdir -p "$OUTDIR" || exit 1
+
+f=0
+while [ "$f" -lt "$FILES" ]; do
+    awk -v file="$f" -v files="$FILES" -v lines="$LINES" -v labels="$LABELS" -v macros="$MACROS" \
+        -v macro_size="$MACRO_SIZE" -v directives="$DIRECTIVES" -v seed="$SEED" '
+    function pick(n) { return int(rand() * n) }
+    function reg() { return "r" (1 + pick(7)) }
+    function num() { return pick(200) - 100 }
+    function label() { return label_count > 0 ? label_names[pick(label_count)] : "E" file "x" pick(exports) }
+    function target() { return pick(10) == 0 && file + 1 < files ? "E" file + 1 "x" pick(exports) : label() }
+    function instruction(operand, choice) {
+        choice = pick(14)
+        if (choice == 0) return "mov #" num() ", " reg()
+        if (choice == 1) return "mov " operand ", " reg()
+        if (choice == 2) return "add " reg() ", " reg()
+        if (choice == 3) return "sub " operand ", *" reg()
+        if (choice == 4) return "cmp #" num() ", " operand
+        if (choice == 5) return "lea " operand ", " reg()
+        if (choice == 6) return "inc " operand
+        if (choice == 7) return "dec " reg()
+        if (choice == 8) return "jmp *" reg()
+        if (choice == 9) return "bne " reg()
+        if (choice == 10) return "red " operand
+        if (choice == 11) return "prn #" num()
+        if (choice == 12) return "clr *" reg()
+        return "not " reg()
+    }
+    function register_instruction(text) {
+        do text = instruction(reg()); while (text ~ /^lea/)
+        return text
+    }
+    function directive(text, i, count) {
+        if (pick(3) == 0) {
+            text = ""
+            count = 1 + pick(8)
+            for (i = 0; i < count; i++) text = text sprintf("%c", 97 + pick(26))
+            return ".string \"" text "\""
+        }
+        count = 1 + pick(6)
+        text = ".data " num()
+        for (i = 1; i < count; i++) text = text ", " num()
+        return text
+    }
+    BEGIN {
+        srand(seed * 1000003 + file)
+        exports = 4
+
+        # Decide the labelled lines first, so instructions may refer forward
+        label_count = 0
+        for (i = 0; i < lines; i++) {
+            if (pick(100) < labels) {
+                labelled[i] = 1
+                label_names[label_count++] = "L" file "x" i
+            }
+        }
+
+        for (m = 0; m < macros; m++) {
+            print "macr M" file "x" m
+            for (j = 0; j < macro_size; j++) print "    " register_instruction()
+            print "endmacr"
+        }
+        if (file + 1 < files) {
+            for (e = 0; e < exports; e++) print ".extern E" file + 1 "x" e
+        }
+
+        for (i = 0; i < lines; i++) {
+            prefix = (i in labelled) ? "L" file "x" i ": " : ""
+            if (prefix == "" && macros > 0 && pick(20) == 0) {
+                print "M" file "x" pick(macros)
+            } else if (pick(100) < directives) {
+                print prefix directive()
+            } else {
+                print prefix instruction(target())
+            }
+        }
+        for (i = 0; i < label_count && i < 8; i++) print ".entry " label_names[i]
+        print "stop"
+        for (e = 0; e < exports; e++) print "E" file "x" e ": .data " e
+    }' > "$OUTDIR/$PREFIX$f.as" || exit 1
+    f=$((f + 1))
+done
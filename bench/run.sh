@@ -0,0 +1,69 @@
+#!/bin/sh
+# Runs the assembler over a ladder of generated workloads and records the --stats
+# report of each as one CSV row: stage times in milliseconds, the counters, and the
+# peak memory in KB. Each size runs RUNS times; times keep the fastest run and peak
+# memory the largest. Counters do not vary between runs, so any change to them in a
+# diff against bench/baseline.csv is a real change in the work done.
+#
+# Usage: bench/run.sh [assembler binary] [results file]
+# Environment: SIZES (body lines per file, default "1000 10000 100000"), FILES
+# (default 4), RUNS (default 3), JOBS (default 1), and GENERATE_OPTIONS, passed on
+# to bench/generate.sh.
+
+BIN=${1:-./assembler}
+RESULTS=${2:-bench/results.csv}
+SIZES=${SIZES:-"1000 10000 100000"}
+FILES=${FILES:-4}
+RUNS=${RUNS:-3}
+JOBS=${JOBS:-1}
+HERE=$(cd "$(dirname "$0")" && pwd)
+WORKDIR=$(mktemp -d)
+BIN=$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")
+
+trap 'rm -rf "$WORKDIR"' EXIT
+
+: > "$RESULTS" || exit 1
+for n in $SIZES; do
+    rm -rf "$WORKDIR/src"
+    "$HERE/generate.sh" -f "$FILES" -l "$n" $GENERATE_OPTIONS "$WORKDIR/src" || exit 1
+    sources=$(cd "$WORKDIR/src" && ls *.as | sed 's/\.as$//')
+
+    run=0
+    while [ "$run" -lt "$RUNS" ]; do
+        (cd "$WORKDIR/src" && "$BIN" --stats -j "$JOBS" $sources 2>&1 > /dev/null) \
+            | grep '^  ' > "$WORKDIR/stats.$run"
+        run=$((run + 1))
+    done
+
+    # Each report line is "  <name> <value> [unit]"; columns follow the report order
+    awk -v size="$n" -v files="$FILES" -v header="$([ -s "$RESULTS" ] || echo 1)" '
+    {
+        unit = ($NF == "ms" || $NF == "KB") ? $NF : ""
+        value = unit != "" ? $(NF - 1) : $NF
+        name = $0
+        sub(/^ +/, "", name)
+        sub(/ +[0-9.]+( +(ms|KB))?$/, "", name)
+        gsub(/ /, "_", name)
+        if (unit != "") name = name "_" tolower(unit)
+        if (!(name in best)) {
+            order[count++] = name
+            best[name] = value
+        } else if (unit == "ms" && value + 0 < best[name] + 0) {
+            best[name] = value
+        } else if (unit == "KB" && value + 0 > best[name] + 0) {
+            best[name] = value
+        }
+    }
+    END {
+        if (header) {
+            printf "body_lines,files"
+            for (i = 0; i < count; i++) printf ",%s", order[i]
+            printf "\n"
+        }
+        printf "%d,%d", size, files
+        for (i = 0; i < count; i++) printf ",%s", best[order[i]]
+        printf "\n"
+    }' "$WORKDIR"/stats.* >> "$RESULTS" || exit 1
+done
+
+cat "$RESULTS"
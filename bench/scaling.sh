@@ -0,0 +1,36 @@
+#!/bin/sh
+# Measures how assembly time grows with the number of emitted words.
+# Each generated source emits exactly N words (a mix of .data values and
+# two-word instructions, closed by a one-word stop); linear growth shows as a flat "ns/word" column.
+#
+# Usage: bench/scaling.sh [assembler binary] [sizes...]
+
+BIN=${1:-./assembler}
+shift 2>/dev/null
+SIZES=${*:-"1000 10000 100000 1000000"}
+WORKDIR=$(mktemp -d)
+BIN=$(cd "$(dirname "$BIN")" && pwd)/$(basename "$BIN")
+
+trap 'rm -rf "$WORKDIR"' EXIT
+
+printf "%10s %12s %10s\n" "words" "seconds" "ns/word"
+for n in $SIZES; do
+    awk -v n="$n" 'BEGIN {
+        for (w = 1; w + 12 <= n; w += 12) {
+            print ".data 1, -2, 3, -4, 5, -6, 7, -8, 9, -10"
+            print "add #1, r2"
+        }
+        for (; w < n; w++) {
+            print ".data 0"
+        }
+        print "stop"
+    }' > "$WORKDIR/bench.as"
+
+    start=$(date +%s%N)
+    (cd "$WORKDIR" && "$BIN" bench > /dev/null 2>&1)
+    end=$(date +%s%N)
+
+    awk -v n="$n" -v ns="$((end - start))" 'BEGIN {
+        printf "%10d %12.3f %10.1f\n", n, ns / 1e9, ns / n
+    }'
+done
@@ -0,0 +1,66 @@
+/**
+ * @file arena.h
+ * @brief Declares a bump allocator for objects that live as long as one assembly.
+ *
+ * Allocations are carved sequentially out of large chunks that are chained together,
+ * so creating an object is a pointer bump and releasing every object is one walk
+ * over the chunk chain.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/**
+ * @brief Header of one chunk of arena memory; the usable bytes follow it.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;  /**< The previously filled chunk */
+    size_t capacity;          /**< Number of usable bytes in this chunk */
+    size_t used;              /**< Number of bytes handed out from this chunk */
+} ArenaChunk;
+
+/**
+ * @brief Structure to represent an arena and its allocation counters.
+ */
+typedef struct Arena {
+    ArenaChunk *chunks;             /**< The chunk currently allocated from, chained to older chunks */
+    unsigned long chunk_count;      /**< Number of chunks obtained from malloc */
+    unsigned long allocation_count; /**< Number of objects allocated from the arena */
+    size_t bytes_used;              /**< Number of bytes handed out, including alignment padding */
+} Arena;
+
+/**
+ * @brief Initializes an empty arena.
+ *
+ * @param arena Pointer to the Arena to initialize.
+ */
+void init_arena(Arena *arena);
+
+/**
+ * @brief Allocates a block from the arena, suitably aligned for any object.
+ *
+ * @param arena Pointer to the Arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the block, or NULL if memory allocation fails.
+ */
+void* arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies a string into the arena.
+ *
+ * @param arena Pointer to the Arena to allocate from.
+ * @param str The string to copy.
+ * @return A pointer to the copy, or NULL if the input is NULL or memory allocation fails.
+ */
+char* arena_strdup(Arena *arena, const char *str);
+
+/**
+ * @brief Releases every chunk of the arena at once and resets it to empty.
+ *
+ * @param arena Pointer to the Arena to free.
+ */
+void free_arena(Arena *arena);
+
+#endif /* ARENA_H */
@@ -2,25 +2,64 @@
 #define ASSEMBLER_H
 
 #include "utils.h"
+#include "error.h"
 #include "preprocessor.h"
 
+struct OutputFiles;
+struct Buffer;
+
+/**
+ * @brief Holds all the state of one assembler run.
+ *
+ * Nothing in the assembler keeps mutable state at file scope, so separate contexts can
+ * be used to run independent assemblies in one process.
+ */
+typedef struct AssemblerContext {
+    ErrorList errors;         /**< Errors reported while preprocessing and assembling */
+    MacroTable macros;        /**< Macros defined by the preprocessed files */
+    struct Buffer *warnings;  /**< Buffer that memory overflow warnings are collected in, or NULL to print them to stderr */
+    bool single_pass;         /**< Whether to patch label references as labels are declared rather than in a second pass */
+} AssemblerContext;
+
+/**
+ * @brief Initializes an assembler context with no errors and no macros.
+ *
+ * @param assembler Pointer to the AssemblerContext to initialize.
+ */
+void init_assembler_context(AssemblerContext *assembler);
+
 /**
- * @brief Performs the assembly process on the given files.
+ * @brief Frees the errors and macros held by an assembler context.
+ *
+ * @param assembler Pointer to the AssemblerContext to free.
+ */
+void free_assembler_context(AssemblerContext *assembler);
+
+/**
+ * @brief Assembles the given files into the contents of their output files.
  *
  * @param file_count The number of files to assemble.
- * @param filenames The array of file names to assemble.
+ * @param contexts The array of contexts holding the preprocessed lines of each file.
+ * @param assembler The assembler context holding the macros and collecting the errors.
+ * @param jobs The number of threads to run the first pass with.
+ * @param output Pointer to the initialized OutputFiles that receive the contents.
  * @return true if assembly was successful for all files, false otherwise.
  */
-bool assemble(int file_count, const char **filenames);
+bool assemble_to_output(int file_count, Context *contexts, AssemblerContext *assembler, int jobs, struct OutputFiles *output);
 
 /**
  * @brief Preprocesses all source files before assembly.
  *
+ * With more than one job, the files are preprocessed concurrently, with the same
+ * result and the same order of errors as preprocessing them one after another.
+ *
  * @param file_count The number of files to preprocess.
  * @param filenames The array of file names to preprocess.
  * @param contexts The array of contexts to store preprocessing results.
+ * @param assembler The assembler context collecting the macros and errors of all the files.
+ * @param jobs The number of threads to preprocess with.
  * @return true if all files were successfully preprocessed, false otherwise.
  */
-bool preprocess_all_files(int file_count, const char **filenames, Context *contexts);
+bool preprocess_all_files(int file_count, const char **filenames, Context *contexts, AssemblerContext *assembler, int jobs);
 
 #endif /* ASSEMBLER_H */
@@ -0,0 +1,78 @@
+/**
+ * @file buffer.h
+ * @brief Declares a growable in-memory byte buffer used to assemble output files.
+ *
+ * Output is formatted into a Buffer first and written out in a single call, so
+ * producing a file costs one open, one write and one rename regardless of its size.
+ */
+
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stddef.h>
+#include "utils.h"
+
+/**
+ * @brief Structure to represent a growable byte buffer.
+ */
+typedef struct Buffer {
+    char *data;               /**< The buffered bytes (not null-terminated) */
+    size_t length;            /**< Number of bytes stored */
+    size_t capacity;          /**< Number of bytes allocated */
+} Buffer;
+
+/**
+ * @brief Initializes an empty buffer.
+ *
+ * @param buffer Pointer to the Buffer to initialize.
+ */
+void init_buffer(Buffer *buffer);
+
+/**
+ * @brief Appends bytes to the buffer, growing it as needed.
+ *
+ * @param buffer Pointer to the Buffer to append to.
+ * @param bytes The bytes to append.
+ * @param length The number of bytes to append.
+ * @return True if the bytes were appended, false if memory allocation failed.
+ */
+bool buffer_append(Buffer *buffer, const char *bytes, size_t length);
+
+/**
+ * @brief Appends a null-terminated string to the buffer.
+ *
+ * @param buffer Pointer to the Buffer to append to.
+ * @param str The string to append.
+ * @return True if the string was appended, false if memory allocation failed.
+ */
+bool buffer_append_string(Buffer *buffer, const char *str);
+
+/**
+ * @brief Writes the buffer to a file atomically.
+ *
+ * The contents are written with a single write to a temporary file next to the
+ * target, which is then renamed over the target path.
+ *
+ * @param buffer Pointer to the Buffer to write.
+ * @param path The path of the file to create or replace.
+ * @return True if the file was written and renamed successfully, false otherwise.
+ */
+bool write_buffer_to_file(const Buffer *buffer, const char *path);
+
+/**
+ * @brief Null-terminates the buffer and hands its contents over to the caller, emptying it.
+ *
+ * @param buffer Pointer to the Buffer to release.
+ * @param length Pointer that receives the number of bytes before the terminator.
+ * @return The contents, which the caller must free, or NULL if memory allocation failed.
+ */
+char* release_buffer(Buffer *buffer, size_t *length);
+
+/**
+ * @brief Frees the memory held by the buffer and resets it to empty.
+ *
+ * @param buffer Pointer to the Buffer to free.
+ */
+void free_buffer(Buffer *buffer);
+
+#endif /* BUFFER_H */
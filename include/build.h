@@ -0,0 +1,103 @@
+/**
+ * @file build.h
+ * @brief Declares the in-memory build of a set of source files and the reporting of its result.
+ *
+ * A build runs the preprocessor and both passes without touching any file it would
+ * write, and keeps everything the run produces. Reporting the build then writes the
+ * files and prints the messages the assembler has always printed. Keeping the two
+ * apart lets the build run in another process, such as an assembler server.
+ */
+
+#ifndef BUILD_H
+#define BUILD_H
+
+#include <stddef.h>
+#include "utils.h"
+#include "buffer.h"
+#include "file_manager.h"
+
+/**
+ * @brief Everything a build produces, held in memory until it is reported.
+ */
+typedef struct BuildResult {
+    bool preprocessed;        /**< Whether every file preprocessed without errors */
+    bool assembled;           /**< Whether the files assembled without errors */
+    int file_count;           /**< Number of files built */
+    Buffer *preprocessed_files; /**< The .am contents of each file, when every file preprocessed */
+    OutputFiles output;       /**< The output file contents, when the files assembled */
+    Buffer warnings;          /**< Memory overflow warnings, as they would be printed */
+    Buffer diagnostics;       /**< Error messages, as they would be printed */
+} BuildResult;
+
+/**
+ * @brief Initializes an empty build result.
+ *
+ * @param result Pointer to the BuildResult to initialize.
+ */
+void init_build_result(BuildResult *result);
+
+/**
+ * @brief Builds source files read from disk.
+ *
+ * @param file_count The number of files.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param jobs The number of threads to preprocess and parse with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ * @param max_errors The number of errors after which the build stops reporting errors, or 0 for no limit.
+ * @param result Pointer to the initialized BuildResult to fill.
+ */
+void build_files(int file_count, const char **filenames, int jobs, bool single_pass, int max_errors, BuildResult *result);
+
+/**
+ * @brief Builds sources whose contents are already in memory.
+ *
+ * @param file_count The number of sources.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param texts The contents of each source; they need not be null-terminated.
+ * @param lengths The number of bytes of each source.
+ * @param jobs The number of threads to parse with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ * @param max_errors The number of errors after which the build stops reporting errors, or 0 for no limit.
+ * @param result Pointer to the initialized BuildResult to fill.
+ */
+void build_sources(int file_count, const char **filenames, const char **texts, const size_t *lengths, int jobs, bool single_pass, int max_errors, BuildResult *result);
+
+/**
+ * @brief Writes the files of a build and prints its messages.
+ *
+ * @param file_count The number of files.
+ * @param filenames The source filenames; their extensions are replaced with ".am".
+ * @param result Pointer to the BuildResult to report.
+ * @param write_preprocessed Whether to write the .am files.
+ * @return True if the assembly succeeded, false otherwise.
+ */
+bool report_build(int file_count, const char **filenames, const BuildResult *result, bool write_preprocessed);
+
+/**
+ * @brief Encodes a build result as bytes that decode_build_result reads back.
+ *
+ * @param result Pointer to the BuildResult to encode.
+ * @param encoded Pointer to the Buffer the encoding is appended to.
+ * @return True if the result was encoded, false if memory allocation failed.
+ */
+bool encode_build_result(const BuildResult *result, Buffer *encoded);
+
+/**
+ * @brief Decodes a build result encoded by encode_build_result.
+ *
+ * @param data The encoded bytes.
+ * @param length The number of encoded bytes.
+ * @param file_count The number of files the result is expected to hold.
+ * @param result Pointer to the initialized BuildResult to fill.
+ * @return True if the bytes held a result for file_count files, false otherwise.
+ */
+bool decode_build_result(const char *data, size_t length, int file_count, BuildResult *result);
+
+/**
+ * @brief Frees everything held by a build result and empties it.
+ *
+ * @param result Pointer to the BuildResult to free.
+ */
+void free_build_result(BuildResult *result);
+
+#endif /* BUILD_H */
@@ -0,0 +1,73 @@
+/**
+ * @file cache.h
+ * @brief Declares the on-disk cache of build results, keyed by the contents of the inputs.
+ *
+ * A cache entry holds the inputs of a build next to its BuildResult. The entry is found
+ * through a hash of the inputs and only used if the inputs it holds match exactly, so a
+ * hash collision costs a rebuild, never a wrong result. Reporting a cached result writes
+ * the same files and prints the same messages as the build it came from.
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "utils.h"
+#include "buffer.h"
+#include "build.h"
+
+#define CACHE_VERSION "assembler-cache-2"  /* Part of every key; change it whenever the entry format changes */
+
+#ifndef ASSEMBLER_BUILD_ID
+#define ASSEMBLER_BUILD_ID "unversioned"   /* Part of every key; the makefile sets it to a checksum of the sources */
+#endif
+#define CACHE_KEY_LENGTH 16                /* Number of hex digits in the name of an entry */
+
+/**
+ * @brief The inputs of a build, and the name of the cache entry they are stored under.
+ */
+typedef struct CacheKey {
+    Buffer inputs;                         /**< The version, build ID, names and contents of the inputs */
+    char name[CACHE_KEY_LENGTH + 1];       /**< Hash of the inputs, in hex */
+} CacheKey;
+
+/**
+ * @brief Reads the source files of a build into a cache key.
+ *
+ * @param file_count The number of files.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param max_errors The error limit of the build, which changes its messages.
+ * @param key Pointer to the CacheKey to fill; free it with free_cache_key.
+ * @return True if every file was read, false otherwise.
+ */
+bool make_cache_key(int file_count, const char **filenames, int max_errors, CacheKey *key);
+
+/**
+ * @brief Looks up the result of a build in the cache.
+ *
+ * @param cache_dir The directory of the cache.
+ * @param key Pointer to the CacheKey of the build.
+ * @param file_count The number of files of the build.
+ * @param result Pointer to the initialized BuildResult to fill.
+ * @return True if the cache held the result, false otherwise; the result is left empty in that case.
+ */
+bool load_cached_build(const char *cache_dir, const CacheKey *key, int file_count, BuildResult *result);
+
+/**
+ * @brief Stores the result of a build in the cache, creating the cache directory if needed.
+ *
+ * A result that cannot be stored is silently left out of the cache.
+ *
+ * @param cache_dir The directory of the cache.
+ * @param key Pointer to the CacheKey of the build.
+ * @param result Pointer to the BuildResult to store.
+ */
+void store_cached_build(const char *cache_dir, const CacheKey *key, const BuildResult *result);
+
+/**
+ * @brief Frees the inputs held by a cache key.
+ *
+ * @param key Pointer to the CacheKey to free.
+ */
+void free_cache_key(CacheKey *key);
+
+#endif /* CACHE_H */
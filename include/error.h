@@ -10,6 +10,10 @@
 #define ERROR_H
 
 #include "utils.h"
+#include "arena.h"
+#include "symbol.h"
+
+struct Buffer;
 
 /**
  * @enum ErrorCode
@@ -42,26 +46,117 @@ typedef enum {
  * @struct Error
  * @brief Represents an error that occurred during assembly.
  *
+ * The message is only formatted when the error is printed.
+ *
  * @var Error::code
  * The code identifying the type of error.
- * @var Error::message
- * The formatted error message.
- * @var Error::filename
- * The name of the file where the error occurred.
+ * @var Error::file
+ * The symbol ID of the name of the file where the error occurred.
  * @var Error::line
  * The line number where the error occurred.
+ * @var Error::detail
+ * The symbol ID of the detail of the message, or NO_SYMBOL if there is none.
  */
 typedef struct {
     ErrorCode code;
-    char message[256];
-    char filename[256];
+    int file;
     int line;
+    int detail;
 } Error;
 
-void init_error_handling();
-void add_error(ErrorCode code, const char *filename, int line, const char *detail);
-void print_errors();
-bool has_errors();
-void free_errors();
+/**
+ * @brief Growable list of the errors reported during an assembly.
+ *
+ * Each assembler context owns one list, so independent assemblies never share error
+ * state. File names and details are interned in the list, so errors are small and a
+ * name repeated across errors is stored once.
+ */
+typedef struct ErrorList {
+    Error *errors;            /**< The recorded errors, in the order they were reported */
+    int count;                /**< Number of errors recorded */
+    int capacity;             /**< Number of errors allocated */
+    int limit;                /**< Number of errors after which further errors are dropped, or 0 for no limit */
+    Arena arena;              /**< Arena holding the interned file names and details */
+    SymbolTable strings;      /**< The file names and details of the errors */
+} ErrorList;
+
+/**
+ * @brief Initializes an error list.
+ *
+ * @param list Pointer to the ErrorList to initialize.
+ */
+void init_error_handling(ErrorList *list);
+
+/**
+ * @brief Adds an error to an error list, unless the list has reached its limit.
+ *
+ * @param list Pointer to the ErrorList to add to.
+ * @param code The error code representing the type of error.
+ * @param filename The name of the file where the error occurred.
+ * @param line The line number where the error occurred.
+ * @param detail Additional details about the error, or NULL.
+ */
+void add_error(ErrorList *list, ErrorCode code, const char *filename, int line, const char *detail);
+
+/**
+ * @brief Appends copies of a range of the errors of one list to the end of another.
+ *
+ * Errors past the limit of the list are dropped.
+ *
+ * @param list Pointer to the ErrorList to append to.
+ * @param other Pointer to the ErrorList whose errors are copied.
+ * @param first The index of the first error to copy.
+ * @param count The number of errors to copy.
+ */
+void append_error_range(ErrorList *list, const ErrorList *other, int first, int count);
+
+/**
+ * @brief Appends copies of every error of one list to the end of another.
+ *
+ * @param list Pointer to the ErrorList to append to.
+ * @param other Pointer to the ErrorList whose errors are copied.
+ */
+void append_errors(ErrorList *list, const ErrorList *other);
+
+/**
+ * @brief Checks if a list has as many errors as its limit allows.
+ *
+ * Parsing stops once this holds, since the errors it would find are dropped.
+ *
+ * @param list Pointer to the ErrorList to check.
+ * @return true if the list has a limit and has reached it, false otherwise.
+ */
+bool error_limit_reached(const ErrorList *list);
+
+/**
+ * @brief Prints all recorded errors to stderr.
+ *
+ * @param list Pointer to the ErrorList to print.
+ */
+void print_errors(const ErrorList *list);
+
+/**
+ * @brief Formats all recorded errors into a buffer, as print_errors would print them.
+ *
+ * @param list Pointer to the ErrorList to format.
+ * @param buffer Pointer to the Buffer to append the messages to.
+ * @return true if every message was appended, false if memory allocation failed.
+ */
+bool format_errors(const ErrorList *list, struct Buffer *buffer);
+
+/**
+ * @brief Checks if any errors have been recorded.
+ *
+ * @param list Pointer to the ErrorList to check.
+ * @return true if errors have been recorded, false otherwise.
+ */
+bool has_errors(const ErrorList *list);
+
+/**
+ * @brief Frees the memory used by an error list and empties it.
+ *
+ * @param list Pointer to the ErrorList to free.
+ */
+void free_errors(ErrorList *list);
 
 #endif /* ERROR_H */
@@ -8,16 +8,38 @@
 #define FILE_MANAGER_H
 
 #include "preprocessor.h"
+#include "error.h"
 #include "utils.h"
 #include "memory.h"
+#include "buffer.h"
 
 /**
- * @brief Creates preprocessed files (.am) from the contexts provided.
+ * @brief The contents of the output files of an assembly, formatted in memory.
+ */
+typedef struct OutputFiles {
+    Buffer entries;           /**< Contents of the .ent file, empty if there are no entries */
+    Buffer externs;           /**< Contents of the .ext file, empty if there are no externs */
+    Buffer object;            /**< Contents of the .ob file, empty if no words were emitted */
+} OutputFiles;
+
+/**
+ * @brief Formats the preprocessed lines of a context as the contents of its .am file.
+ *
+ * @param context Pointer to the Context holding the preprocessed lines.
+ * @param contents Pointer to the Buffer that receives the contents.
+ * @return True if the contents were formatted, false if memory allocation failed.
+ */
+bool format_preprocessed_file(const Context *context, Buffer *contents);
+
+/**
+ * @brief Writes the preprocessed (.am) file of each source from its formatted contents.
  *
- * @param file_count The number of files to process.
- * @param contexts An array of Context structures containing preprocessed lines.
+ * @param file_count The number of files to write.
+ * @param filenames The source filenames the .am names are derived from.
+ * @param contents The .am contents of each file.
+ * @param errors The error list that failed writes are reported to.
  */
-void create_preprocessed_files(int file_count, Context *contexts);
+void write_preprocessed_files(int file_count, const char **filenames, const Buffer *contents, ErrorList *errors);
 
 /**
  * @brief Prepares and validates filenames based on the command-line arguments.
@@ -25,13 +47,14 @@ void create_preprocessed_files(int file_count, Context *contexts);
  * This function appends the ".as" suffix if it's not already present and checks
  * that each file exists.
  *
- * @param argc The number of command-line arguments.
- * @param argv The list of command-line arguments.
+ * @param argc The number of source file arguments.
+ * @param argv The list of source file arguments (the command line after any options).
  * @param filenames_ptr A pointer to store the list of prepared filenames.
  * @param file_count A pointer to store the count of filenames.
+ * @param errors The error list that a missing file is reported to.
  * @return True if filenames were prepared successfully, false otherwise.
  */
-bool prepare_filenames(int argc, char *argv[], const char ***filenames_ptr, int *file_count);
+bool prepare_filenames(int argc, char *argv[], const char ***filenames_ptr, int *file_count, ErrorList *errors);
 
 /**
  * @brief Frees the memory allocated for the list of filenames.
@@ -42,49 +65,78 @@ bool prepare_filenames(int argc, char *argv[], const char ***filenames_ptr, int
 void free_filenames(const char **filenames, int file_count);
 
 /**
- * @brief Writes all necessary output files (.ent, .ext, .ob) based on the assembler's memory content.
+ * @brief Initializes empty output file contents.
+ *
+ * @param output Pointer to the OutputFiles to initialize.
+ */
+void init_output_files(OutputFiles *output);
+
+/**
+ * @brief Formats the contents of the output files (.ent, .ext, .ob) from the assembler's memory content.
+ *
+ * @param mem A pointer to the Memory structure containing the assembler's state.
+ * @param output Pointer to the OutputFiles that receive the contents.
+ * @return True if the contents were formatted, false if memory allocation failed.
+ */
+bool format_output_files(const Memory *mem, OutputFiles *output);
+
+/**
+ * @brief Writes all necessary output files (.ent, .ext, .ob) from their formatted contents.
+ *
+ * Each file is written once and renamed into place.
  *
  * @param filenames The list of source filenames.
  * @param file_count The number of source files.
- * @param mem A pointer to the Memory structure containing the assembler's state.
+ * @param output Pointer to the formatted OutputFiles.
+ * @param errors The error list that failed writes are reported to.
  */
-void write_output_files(const char **filenames, int file_count, Memory *mem);
+void write_output_files(const char **filenames, int file_count, const OutputFiles *output, ErrorList *errors);
 
 /**
- * @brief Writes to the entry (.ent) file for a given label.
+ * @brief Frees the contents of the output files.
  *
+ * @param output Pointer to the OutputFiles to free.
+ */
+void free_output_files(OutputFiles *output);
+
+/**
+ * @brief Formats an entry (.ent) file line for a given label.
+ *
+ * @param entries The buffer holding the entry file contents.
  * @param name The label name.
  * @param address The label's address in memory.
- * @param filename The base filename for the output file.
+ * @return True if the line was appended, false if memory allocation failed.
  */
-void write_to_entry_file(char *name, int address, char *filename);
+bool write_to_entry_file(Buffer *entries, const char *name, int address);
 
 /**
- * @brief Writes to the extern (.ext) file for a given label.
+ * @brief Formats an extern (.ext) file line for a given label.
  *
+ * @param externs The buffer holding the extern file contents.
  * @param name The label name.
  * @param address The label's address in memory.
- * @param filename The base filename for the output file.
+ * @return True if the line was appended, false if memory allocation failed.
  */
-void write_to_extern_file(char *name, int address, char *filename);
+bool write_to_extern_file(Buffer *externs, const char *name, int address);
 
 /**
- * @brief Writes to the object (.ob) file for the assembled program.
+ * @brief Formats an object (.ob) file line for a single word.
  *
- * @param address The memory address to write to.
- * @param data The data to write.
- * @param filename The base filename for the output file.
- * @param mem A pointer to the Memory structure containing the assembler's state.
+ * @param object The buffer holding the object file contents.
+ * @param address The memory address of the word.
+ * @param data The word to write.
+ * @return True if the line was appended, false if memory allocation failed.
  */
-void write_to_object_file(int address, int data, char *filename, Memory *mem);
+bool write_to_object_file(Buffer *object, int address, int data);
 
 /**
  * @brief Deletes a file with the specified filename and extension.
  *
  * @param filename The base filename.
  * @param extension The file extension to delete.
+ * @param errors The error list that a failed deletion is reported to.
  */
-void delete_file(const char *filename, const char *extension);
+void delete_file(const char *filename, const char *extension, ErrorList *errors);
 
 /**
  * @brief Extracts and formats filenames into a single string with underscores separating each filename.
@@ -105,8 +157,9 @@ char* extract_and_format_filename(const char **filenames, int file_count);
  *
  * @param filenames The list of source filenames.
  * @param file_count The number of files in the list.
+ * @param errors The error list that failed deletions are reported to.
  */
-void delete_output_files(const char **filenames, int file_count);
+void delete_output_files(const char **filenames, int file_count, ErrorList *errors);
 
 /**
  * @brief Replaces the file extension of each filename in the list with ".am".
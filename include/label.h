@@ -10,76 +10,109 @@
 #define LABEL_H
 
 #include "utils.h"
+#include "arena.h"
+#include "symbol.h"
 
 /**
  * @brief Structure to represent a label in assembly code.
  */
 typedef struct Label {
-    char *name;               /**< The name of the label */
-    char *file_name;          /**< The file name where the label is declared */
+    char *name;               /**< The name of the label (interned, not owned by the label) */
+    char *file_name;          /**< The file name where the label is declared (not owned by the label) */
     int address;              /**< The memory address associated with the label */
     int line_number;          /**< The line number where the label is declared */
     bool is_instruction;      /**< Whether the label is associated with an instruction */
     bool entry;               /**< Whether the label is marked as an entry */
     bool external;            /**< Whether the label is marked as external */
     bool declared;            /**< Whether the label has been declared */
-    struct Label *next;       /**< Pointer to the next label in the list */
+    int symbol;               /**< Symbol ID of the label name */
+    int fixup_chain;          /**< Index in the fixups of the latest reference to the label, or -1 */
+    struct Label *next;       /**< Pointer to the next label in insertion order */
 } Label;
 
 /**
- * @brief Creates a new label with the provided details.
+ * @brief Table of labels indexed by the symbol IDs of their names.
  *
- * @param name The name of the label.
+ * Names are hashed once, when they are interned in the symbol table; after that a
+ * lookup is an array index. The labels themselves stay chained through Label::next in
+ * insertion order so output is written in the order the labels were first seen. Labels
+ * are allocated from an arena owned by the caller, so the table never frees them one by one.
+ */
+typedef struct LabelTable {
+    Arena *arena;             /**< Arena the labels are allocated from */
+    SymbolTable *symbols;     /**< Symbol table the label names are interned in */
+    Label **slots;            /**< Label of each symbol ID, NULL where the symbol names no label */
+    int capacity;             /**< Number of slots allocated */
+    int count;                /**< Number of labels stored */
+    Label *head;              /**< First label in insertion order */
+    Label *tail;              /**< Last label in insertion order */
+} LabelTable;
+
+/**
+ * @brief Creates a new label with the provided details in the given arena.
+ *
+ * @param arena The arena to allocate the label from.
+ * @param name The interned name of the label; it is referenced, not copied.
+ * @param symbol The symbol ID of the name.
  * @param address The address associated with the label.
  * @param is_instruction Whether the label is associated with an instruction.
  * @param entry Whether the label is marked as an entry.
  * @param external Whether the label is marked as external.
- * @param file_name The name of the file where the label is declared.
+ * @param file_name The name of the file where the label is declared; it is referenced, not copied.
  * @param declared Whether the label has been declared.
  * @param line_number The line number where the label is declared.
  * @return A pointer to the newly created label, or NULL if memory allocation fails.
  */
-Label* create_label(char *name, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number);
+Label* create_label(Arena *arena, char *name, int symbol, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number);
+
+/**
+ * @brief Initializes an empty label table.
+ *
+ * @param table Pointer to the LabelTable to initialize.
+ * @param arena The arena that labels added to the table are allocated from.
+ * @param symbols The symbol table that label names are interned in.
+ */
+void init_label_table(LabelTable *table, Arena *arena, SymbolTable *symbols);
 
 /**
- * @brief Adds a label to the label list.
+ * @brief Adds a label to the label table, or updates it if a label with the same name exists.
  *
- * @param label_list Pointer to the head of the label list.
- * @param name The name of the label.
+ * @param table Pointer to the label table.
+ * @param symbol The symbol ID of the label name, interned in the table's symbol table.
  * @param address The address associated with the label.
  * @param is_instruction Whether the label is associated with an instruction.
  * @param entry Whether the label is marked as an entry.
  * @param external Whether the label is marked as external.
- * @param file_name The name of the file where the label is declared.
+ * @param file_name The name of the file where the label is declared; it is referenced, not copied.
  * @param declared Whether the label has been declared.
  * @param line_number The line number where the label is declared.
- * @return True if the label was added successfully, otherwise false.
+ * @return A pointer to the added or updated label, or NULL if memory allocation fails.
  */
-bool add_label(Label **label_list, char *line, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number);
+Label* add_label(LabelTable *table, int symbol, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number);
 
 /**
- * @brief Finds a label by its name in the label list.
+ * @brief Finds a label by its name in the label table.
  *
- * @param label_list The list of labels.
+ * @param table The label table.
  * @param name The name of the label to find.
  * @return A pointer to the found label, or NULL if the label is not found.
  */
-Label* find_label(Label *label_list, char *name);
+Label* find_label(const LabelTable *table, const char *name);
 
 /**
- * @brief Checks if a token matches any label in the label list.
+ * @brief Finds a label by the symbol ID of its name.
  *
- * @param token The token to check.
- * @param label_list The list of labels.
- * @return True if the token matches a label, otherwise false.
+ * @param table The label table.
+ * @param symbol The symbol ID of the name, interned in the table's symbol table.
+ * @return A pointer to the found label, or NULL if the symbol names no label.
  */
-bool is_label(const char *token, Label *label_list);
+Label* find_symbol_label(const LabelTable *table, int symbol);
 
 /**
- * @brief Frees the memory allocated for the label list.
+ * @brief Frees the slot array of the label table; the labels are released with their arena.
  *
- * @param label_list The list of labels to free.
+ * @param table The label table to free.
  */
-void free_labels(Label *label_list);
+void free_labels(LabelTable *table);
 
 #endif /* LABEL_H */
@@ -0,0 +1,97 @@
+/**
+ * @file lexer.h
+ * @brief Declares the line lexer used by the parser.
+ *
+ * A line is tokenized exactly once into a small array of (offset, length, kind) spans.
+ * The lexer keeps its own copy of the line in which every token is null-terminated,
+ * so handlers can use the tokens as strings without re-tokenizing or copying the line.
+ */
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "utils.h"
+#include "operations.h"
+
+#define MAX_LINE_TOKENS 32  /* Tokens lexed at a time; longer lines are lexed in batches */
+
+/**
+ * @brief The role a token plays when it starts a statement.
+ */
+typedef enum {
+    TOKEN_OPERAND,                 /**< Anything else: operands, values, strings */
+    TOKEN_COMMENT,                 /**< Starts with ';' */
+    TOKEN_LABEL,                   /**< Contains ':' */
+    TOKEN_DATA,                    /**< Contains ".data" */
+    TOKEN_STRING,                  /**< Contains ".string" */
+    TOKEN_ENTRY,                   /**< Contains ".entry" */
+    TOKEN_EXTERN,                  /**< Contains ".extern" */
+    TOKEN_NO_OPERAND_INSTRUCTION,  /**< Contains "rts" or "stop" */
+    TOKEN_INSTRUCTION              /**< Exactly an operation mnemonic */
+} TokenKind;
+
+/**
+ * @brief A single token, located by its offset and length in the lexer's copy of the line.
+ */
+typedef struct Token {
+    int offset;               /**< Offset of the first character in LineTokens::text */
+    int length;               /**< Number of characters in the token */
+    TokenKind kind;           /**< The role of the token when it starts a statement */
+    const Keyword *keyword;   /**< The keyword the token is exactly, or NULL */
+} Token;
+
+/**
+ * @brief The tokens of one line.
+ */
+typedef struct LineTokens {
+    char *text;               /**< Copy of the line with every token null-terminated */
+    int text_capacity;        /**< Allocated size of text, reused from line to line */
+    int text_length;          /**< Length of the line */
+    Token tokens[MAX_LINE_TOKENS]; /**< The tokens of the current batch */
+    int count;                /**< Number of tokens in the current batch */
+    int next_offset;          /**< Offset to resume lexing from when the batch was full */
+} LineTokens;
+
+/**
+ * @brief Initializes an empty set of line tokens.
+ *
+ * @param tokens Pointer to the LineTokens to initialize.
+ */
+void init_line_tokens(LineTokens *tokens);
+
+/**
+ * @brief Tokenizes a line into its first batch of tokens.
+ *
+ * Tokens are separated by spaces, tabs and commas.
+ *
+ * @param tokens Pointer to the LineTokens to fill.
+ * @param line The line to tokenize; it is not modified.
+ * @return True if the line was tokenized, false if memory allocation failed.
+ */
+bool lex_line(LineTokens *tokens, const char *line);
+
+/**
+ * @brief Replaces the current batch with the next batch of tokens of the same line.
+ *
+ * @param tokens Pointer to the LineTokens of a line previously passed to lex_line.
+ * @return True if more tokens were lexed, false if the line has no more tokens.
+ */
+bool lex_next_batch(LineTokens *tokens);
+
+/**
+ * @brief Returns the null-terminated text of a token.
+ *
+ * @param tokens Pointer to the LineTokens holding the token.
+ * @param index The index of the token in the current batch.
+ * @return The token text, or NULL if the index is past the end of the batch.
+ */
+char* token_text(const LineTokens *tokens, int index);
+
+/**
+ * @brief Frees the memory held by the line tokens.
+ *
+ * @param tokens Pointer to the LineTokens to free.
+ */
+void free_line_tokens(LineTokens *tokens);
+
+#endif /* LEXER_H */
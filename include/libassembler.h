@@ -0,0 +1,71 @@
+/**
+ * @file libassembler.h
+ * @brief Declares the in-memory interface of the assembler library.
+ *
+ * assemble_buffers runs the whole assembly on sources the caller holds in memory and
+ * returns what the command-line assembler would have written to the .ob, .ent and .ext
+ * files, along with the error messages and memory overflow warnings it would have
+ * printed. Nothing is read from or written to disk, and no messages are printed. Every
+ * call keeps its own state, so calls may run on several threads at once.
+ *
+ * The header only depends on the standard library, so it can be included on its own
+ * by programs that link against libassembler.a or libassembler.so. The functions
+ * declared here are the only symbols libassembler.so exports.
+ */
+
+#ifndef LIBASSEMBLER_H
+#define LIBASSEMBLER_H
+
+#include <stddef.h>
+
+/**
+ * @brief One source file of an assembly, held in memory.
+ */
+typedef struct AssemblySource {
+    const char *name;         /**< Name of the source, used in error messages and to tell the files apart */
+    const char *text;         /**< The source text; it need not be null-terminated */
+    size_t length;            /**< Number of bytes of text */
+} AssemblySource;
+
+/**
+ * @brief The outcome of an assembly, in buffers owned by the caller.
+ *
+ * Every buffer is null-terminated, and its length does not count the terminator.
+ * The output buffers are empty when the assembly fails, or when there is nothing to
+ * put in the corresponding file.
+ */
+typedef struct AssemblyResult {
+    char *object;             /**< Contents of the .ob file */
+    size_t object_length;     /**< Length of the object contents */
+    char *entries;            /**< Contents of the .ent file */
+    size_t entries_length;    /**< Length of the entry contents */
+    char *externs;            /**< Contents of the .ext file */
+    size_t externs_length;    /**< Length of the extern contents */
+    char *diagnostics;        /**< Error messages, one per line */
+    size_t diagnostics_length; /**< Length of the error messages */
+    char *warnings;           /**< Memory overflow warnings, one per line */
+    size_t warnings_length;   /**< Length of the warnings */
+    int error_count;          /**< Number of errors reported */
+} AssemblyResult;
+
+/**
+ * @brief Assembles sources held in memory, as if they were files given on the command line.
+ *
+ * Macros of a source are visible to the sources after it, and labels are shared by all
+ * of them, just as for the files of one command line.
+ *
+ * @param sources The sources to assemble, in order.
+ * @param count The number of sources.
+ * @param result Pointer to the AssemblyResult to fill; free it with free_assembly_result.
+ * @return Non-zero if the sources were assembled without errors, zero otherwise.
+ */
+int assemble_buffers(const AssemblySource *sources, int count, AssemblyResult *result);
+
+/**
+ * @brief Frees the buffers of an assembly result.
+ *
+ * @param result Pointer to the AssemblyResult to free.
+ */
+void free_assembly_result(AssemblyResult *result);
+
+#endif /* LIBASSEMBLER_H */
@@ -10,9 +10,13 @@
 #define MEMORY_H
 
 #include "label.h"
+#include "arena.h"
+#include "symbol.h"
 
 #define MEMORY_SIZE 4096  /* Number of memory cells */
 #define WORD_SIZE 15      /* Each memory cell is 15 bits */
+#define LOAD_ADDRESS 100  /* Address the instruction image is loaded at */
+#define INITIAL_DC 100    /* Initial value of the Data Counter */
 
 /**
  * @brief Defines a 15-bit word.
@@ -20,28 +24,111 @@
 typedef unsigned short Word;  /* 15-bit word (use unsigned short and mask to 15 bits) */
 
 /**
- * @brief Structure to represent a node in the instruction or data list.
+ * @brief Growable contiguous image of words, appended to in O(1) amortized time.
+ *
+ * A word's address is not stored: every word advances its counter by one, so the
+ * address follows from the word's index, as computed by instruction_address and
+ * data_address once the size of the instruction image is known.
+ */
+typedef struct WordBuffer {
+    Word *words;              /**< The words, indexed by their offset in the image */
+    int count;                /**< Number of words stored */
+    int capacity;             /**< Number of words allocated */
+} WordBuffer;
+
+struct MacroTable;
+struct Buffer;
+
+/**
+ * @brief A word that holds a label reference, patched once the label's final address is known.
+ */
+typedef struct Fixup {
+    int word_index;           /**< Index of the word in the instruction buffer */
+    Label *label;             /**< The referenced label */
+    int next;                 /**< Index of the previous fixup of the same label, or -1 */
+} Fixup;
+
+/**
+ * @brief Growable list of fixups, in the order the references were emitted.
+ */
+typedef struct FixupBuffer {
+    Fixup *fixups;            /**< The fixups */
+    int count;                /**< Number of fixups stored */
+    int capacity;             /**< Number of fixups allocated */
+} FixupBuffer;
+
+/**
+ * @enum LabelEventKind
+ * @brief The label operations of the first pass that depend on labels of earlier files.
+ */
+typedef enum {
+    LABEL_DECLARED,           /* A label was declared on a line */
+    LABEL_ENTRY,              /* A label was named by .entry */
+    LABEL_EXTERN,             /* A label was named by .extern */
+    LABEL_REFERENCED          /* A label was used as an operand */
+} LabelEventKind;
+
+/**
+ * @brief A label operation recorded while parsing a file apart from the others.
+ */
+typedef struct LabelEvent {
+    LabelEventKind kind;      /**< What happened to the label */
+    int symbol;               /**< Symbol ID of the label name, interned in the memory that logged it */
+    int line_number;          /**< The line the operation came from */
+    int address;              /**< The address of a declared label, counted from the start of the file */
+    bool is_instruction;      /**< Whether a declared label is associated with an instruction */
+    int word_index;           /**< Index in the file's instruction buffer of a referencing word, or -1 */
+    int error_count;          /**< Number of errors the file had reported before the operation */
+} LabelEvent;
+
+/**
+ * @brief Growable list of label events, in the order they happened.
+ */
+typedef struct LabelLog {
+    LabelEvent *events;       /**< The events */
+    int count;                /**< Number of events stored */
+    int capacity;             /**< Number of events allocated */
+} LabelLog;
+
+/**
+ * @brief A run of consecutive increments of the same counter.
+ */
+typedef struct CounterRun {
+    bool data;                /**< Whether the Data Counter was incremented rather than the Instruction Counter */
+    int count;                /**< Number of increments in the run */
+} CounterRun;
+
+/**
+ * @brief Growable list of counter runs, in the order the increments happened.
  */
-typedef struct ListNode {
-    int address;              /**< The memory address */
-    Word data;                /**< The data stored at the address */
-    char *label_name;         /**< The label associated with this memory location, if any */
-    struct ListNode *next;    /**< Pointer to the next node */
-} ListNode;
+typedef struct CounterLog {
+    CounterRun *runs;         /**< The runs */
+    int count;                /**< Number of runs stored */
+    int capacity;             /**< Number of runs allocated */
+} CounterLog;
 
 /**
  * @brief Structure to represent the memory, including counters and lists.
  */
 typedef struct Memory {
-    Word memory[MEMORY_SIZE]; /**< The actual memory cells */
     int IC;                   /**< Instruction Counter */
     int DC;                   /**< Data Counter */
     int current_line_number;  /**< The current line number being processed */
-    char *current_line;       /**< The current line being processed */
-    char *current_file;       /**< The current file being processed */
-    ListNode *instructionList;/**< Linked list of instructions */
-    ListNode *dataList;       /**< Linked list of data */
-    Label *label_list;        /**< Linked list of labels */
+    const char *current_line; /**< The rest of the line being processed, past any labels */
+    char *current_file;       /**< The current file being processed (interned, so files compare by pointer) */
+    WordBuffer instructions;  /**< Buffer of instruction words */
+    WordBuffer data;          /**< Buffer of data words */
+    FixupBuffer fixups;       /**< Instruction words that refer to labels */
+    SymbolTable symbols;      /**< Interned label and file names */
+    LabelTable labels;        /**< Labels, indexed by the symbol IDs of their names */
+    Arena arena;              /**< Arena holding labels and strings until the memory is cleared */
+    const struct MacroTable *macros; /**< Macros of the assembly, which label names must not reuse */
+    struct ErrorList *errors; /**< Error list of the assembly that errors are reported to */
+    struct Buffer *warnings;  /**< Buffer that overflow warnings are collected in, or NULL to print them to stderr */
+    bool isolated;            /**< Whether the memory holds one file parsed apart from the files before it */
+    bool single_pass;         /**< Whether label references are patched as the labels are declared */
+    LabelLog label_log;       /**< Label operations recorded instead of applied while isolated */
+    CounterLog counter_log;   /**< Order of the counter increments while isolated */
 } Memory;
 
 /**
@@ -52,23 +139,55 @@ typedef struct Memory {
 void initialize_memory(Memory *mem);
 
 /**
- * @brief Writes a word to the specified memory address and updates the corresponding linked list.
+ * @brief Appends a word to the instruction or data image, at the address of the current counter.
  *
  * @param mem Pointer to the Memory structure.
- * @param address The memory address to write to.
  * @param word The word to write to memory.
  * @param isInstruction Flag indicating whether the word is an instruction (1) or data (0).
- * @param label_name The name of the label associated with the memory word, if any.
+ * @return True if the word was stored, false if memory allocation failed.
  */
-void write_to_memory(Memory *mem, int address, Word word, int isInstruction, char *label_name);
+bool write_to_memory(Memory *mem, Word word, int isInstruction);
 
 /**
- * @brief Stores the current line in memory, freeing any previously stored line.
+ * @brief Computes the final address of a word of the instruction image.
+ *
+ * @param index The index of the word in the instruction image.
+ * @return The address of the word.
+ */
+int instruction_address(int index);
+
+/**
+ * @brief Computes the final address of a word of the data image, which follows the instruction image.
+ *
+ * @param mem Pointer to the Memory structure, whose Instruction Counter is final.
+ * @param index The index of the word in the data image.
+ * @return The address of the word.
+ */
+int data_address(const Memory *mem, int index);
+
+/**
+ * @brief Records that an instruction word refers to a label and must be patched with its address.
+ *
+ * The fixup is also chained onto the label's earlier fixups, so the references to one
+ * label can be patched without walking the others.
  *
  * @param mem Pointer to the Memory structure.
- * @param line The line to store.
+ * @param word_index The index of the word in the instruction buffer.
+ * @param label The referenced label.
  */
-void write_current_line(Memory *mem, char *line);
+void add_fixup(Memory *mem, int word_index, Label *label);
+
+/**
+ * @brief Records a label operation to be replayed once the labels of earlier files are known.
+ *
+ * @param mem Pointer to the Memory structure.
+ * @param kind What happened to the label.
+ * @param symbol The symbol ID of the label name.
+ * @param address The address of a declared label.
+ * @param is_instruction Whether a declared label is associated with an instruction.
+ * @param word_index Index of a referencing word in the instruction buffer, or -1.
+ */
+void add_label_event(Memory *mem, LabelEventKind kind, int symbol, int address, bool is_instruction, int word_index);
 
 /**
  * @brief Increments the Instruction Counter (IC).
@@ -85,7 +204,17 @@ void increment_IC(Memory *mem);
 void increment_DC(Memory *mem);
 
 /**
- * @brief Clears all memory, including the instruction list, data list, and labels.
+ * @brief Reports the overflow warnings the increments of an isolated memory would have reported.
+ *
+ * @param mem Pointer to the Memory structure the warnings are reported for.
+ * @param part Pointer to the isolated Memory structure.
+ * @param IC The Instruction Counter its increments would have started from.
+ * @param DC The Data Counter its increments would have started from.
+ */
+void report_counter_overflows(Memory *mem, const Memory *part, int IC, int DC);
+
+/**
+ * @brief Clears all memory, including the instruction buffer, data buffer, fixups, and labels.
  *
  * @param mem Pointer to the Memory structure to clear.
  */
@@ -95,9 +224,10 @@ void clear_memory(Memory *mem);
  * @brief Converts a word to its binary representation.
  *
  * @param word The word to convert.
- * @return A string representing the binary value of the word.
+ * @param binary Buffer of at least WORD_SIZE + 1 characters that receives the string.
+ * @return The binary buffer, holding the binary value of the word.
  */
-char *word_to_binary(Word word);
+char *word_to_binary(Word word, char *binary);
 
 /**
  * @brief Prints the contents of memory, including instructions, data, and labels.
@@ -106,11 +236,4 @@ char *word_to_binary(Word word);
  */
 void print_memory(const Memory *mem);
 
-/**
- * @brief Moves to the next word in the current line, updating the current_line pointer.
- *
- * @param mem Pointer to the Memory structure.
- */
-void move_to_next_word(Memory *mem);
-
 #endif /* MEMORY_H */
@@ -1,31 +1,67 @@
 #ifndef OPERATIONS_H
 #define OPERATIONS_H
 
+#include <stddef.h>
+#include "constants.h"
+
+#define INVALID_OPCODE 0xFFFF      /**< Opcode of the keywords that are not operations. */
+#define NUM_OPERATIONS 16          /**< Number of supported operations. */
+
+/* Addressing-mode masks; the mode constants are distinct bits, so a mode is allowed when (mask & mode) != 0 */
+#define NO_MODES 0
+#define REGISTER_MODES (INDIRECT_REGISTER_MODE | DIRECT_REGISTER_MODE)
+#define WRITABLE_MODES (DIRECT_MODE | REGISTER_MODES)
+#define ALL_MODES (IMMEDIATE_MODE | WRITABLE_MODES)
+
+/**
+ * @brief The opcodes of the supported operations.
+ */
+typedef enum {
+    OP_MOV, OP_CMP, OP_ADD, OP_SUB, OP_LEA, OP_CLR, OP_NOT, OP_INC,
+    OP_DEC, OP_JMP, OP_BNE, OP_RED, OP_PRN, OP_JSR, OP_RTS, OP_STOP
+} Opcode;
+
+/**
+ * @brief The directive a keyword names, if any.
+ */
+typedef enum {
+    DIRECTIVE_NONE,               /**< The keyword is an operation mnemonic. */
+    DIRECTIVE_DATA,               /**< .data */
+    DIRECTIVE_STRING,             /**< .string */
+    DIRECTIVE_ENTRY,              /**< .entry */
+    DIRECTIVE_EXTERN              /**< .extern */
+} DirectiveKind;
+
 /**
- * @brief Structure to represent an assembly operation.
+ * @brief Structure to represent a keyword of the assembly language.
  *
- * This structure contains the mnemonic (name) of the operation and its corresponding opcode.
+ * Operations carry their opcode, the number of operands they take and the addressing
+ * modes each operand accepts; directives carry the kind of directive they name.
  */
 typedef struct {
-    const char *mnemonic;         /**< The mnemonic (name) of the operation. */
-    unsigned short opcode;        /**< The opcode associated with the mnemonic. */
-} Operation;
-
-#define NUM_OPERATIONS 16          /**< Number of supported operations. */
+    const char *name;             /**< The mnemonic or directive name. */
+    unsigned short opcode;        /**< The opcode, or INVALID_OPCODE for directives. */
+    int operand_count;            /**< Number of operands an operation takes, -1 for directives. */
+    DirectiveKind directive;      /**< The directive kind, DIRECTIVE_NONE for operations. */
+    int source_modes;             /**< Mask of addressing modes allowed for the source operand. */
+    int dest_modes;               /**< Mask of addressing modes allowed for the destination operand. */
+} Keyword;
 
 /**
- * @brief Retrieve the array of supported operations.
+ * @brief Looks up a token among the mnemonics and directives with a single hash probe.
  *
- * @return A pointer to the array of supported operations.
+ * @param token The token to look up; it does not need to be null-terminated.
+ * @param length The length of the token.
+ * @return The matching keyword, or NULL if the token is not a keyword.
  */
-const Operation* get_operations();
+const Keyword* find_keyword(const char *token, size_t length);
 
 /**
- * @brief Get the opcode for a given mnemonic.
+ * @brief Gets the operation with the given opcode.
  *
- * @param mnemonic The mnemonic to look up.
- * @return The opcode associated with the mnemonic, or 0xFFFF if the mnemonic is invalid.
+ * @param opcode The opcode to look up.
+ * @return The operation keyword, or NULL if the opcode is out of range.
  */
-unsigned short get_opcode(const char *mnemonic);
+const Keyword* get_operation(unsigned short opcode);
 
 #endif /* OPERATIONS_H */
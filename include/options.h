@@ -0,0 +1,49 @@
+/**
+ * @file options.h
+ * @brief Declares the command-line options accepted by the assembler.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include "utils.h"
+
+#define MAX_JOBS 256              /* Upper limit of the -j option */
+#define MAX_ERROR_LIMIT 100000000 /* Upper limit of the --max-errors option */
+
+/**
+ * @brief Structure to hold the options parsed from the command line.
+ */
+typedef struct Options {
+    bool write_preprocessed;  /**< Whether to write the expanded sources to .am files */
+    bool print_stats;         /**< Whether to report stage timings and counters */
+    int jobs;                 /**< Number of threads to preprocess and parse with */
+    bool single_pass;         /**< Whether to patch label references as labels are declared */
+    int max_errors;           /**< Number of errors after which assembly stops, or 0 for no limit */
+    const char *serve_socket; /**< Socket to serve builds on, or NULL */
+    const char *client_socket; /**< Socket of a server to send the build to, or NULL */
+    const char *cache_dir;    /**< Directory of the build cache, or NULL */
+} Options;
+
+/**
+ * @brief Parses the leading options from the command-line arguments.
+ *
+ * Options must precede the source files. Parsing stops at the first argument that
+ * is not an option, or after a "--" separator.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The list of command-line arguments.
+ * @param options Pointer to the Options structure to fill.
+ * @param first_file Pointer to store the index of the first source file argument.
+ * @return True if all options were recognized and can be combined, false otherwise.
+ */
+bool parse_options(int argc, char *argv[], Options *options, int *first_file);
+
+/**
+ * @brief Prints the command-line usage of the assembler.
+ *
+ * @param program The name the program was invoked with.
+ */
+void print_usage(const char *program);
+
+#endif /* OPTIONS_H */
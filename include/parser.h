@@ -10,22 +10,38 @@
 #define PARSER_H
 
 #include "memory.h"
+#include "error.h"
+#include "preprocessor.h"
+#include "lexer.h"
 
 /**
- * @brief Parses the given assembly file and processes its contents.
+ * @brief The first pass over one file, parsed apart from the files before it.
  *
- * @param filename The name of the file to parse.
+ * The words of a section are addressed from zero, and its label operations are logged
+ * rather than applied, since both depend on the files before it. Joining the sections
+ * in file order gives the same result as parsing the files one after another.
+ */
+typedef struct Section {
+    Memory memory;            /**< Words, counters and label log of the file */
+    ErrorList errors;         /**< Errors found in the file while it was parsed */
+} Section;
+
+/**
+ * @brief Parses the preprocessed lines held by a context and processes their contents.
+ *
+ * @param context Pointer to the Context holding the preprocessed lines of one file.
  * @param mem Pointer to the Memory structure.
  */
-void parse_file(const char *filename, Memory *mem);
+void parse_context(Context *context, Memory *mem);
 
 /**
  * @brief Parses a line of assembly code.
  *
  * @param line The line of assembly code to parse.
+ * @param tokens Pointer to the LineTokens reused to tokenize the line.
  * @param mem Pointer to the Memory structure.
  */
-void parse_line(char *line, Memory *mem);
+void parse_line(const char *line, LineTokens *tokens, Memory *mem);
 
 /**
  * @brief Parses an instruction with no operands.
@@ -38,10 +54,11 @@ void handle_no_operand_instruction(char *line, Memory *mem);
 /**
  * @brief Handles label declarations and stores them in the memory structure.
  *
- * @param current_token The current token being processed.
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the label token.
  * @param mem Pointer to the Memory structure.
  */
-void handle_label(const char *current_token, Memory *mem);
+void handle_label(const LineTokens *tokens, int index, Memory *mem);
 
 /**
  * @brief Determines the addressing mode of an operand.
@@ -61,28 +78,81 @@ int get_addressing_mode(char *operand);
 void handle_operand(char *operand, int address_mode, Memory *mem);
 
 /**
- * @brief Resolves labels and updates memory with final addresses.
+ * @brief Initializes a section for parsing one file apart from the others.
+ *
+ * @param section Pointer to the Section to initialize.
+ * @param macros The macros of the assembly, which label names must not reuse.
+ */
+void init_section(Section *section, const struct MacroTable *macros);
+
+/**
+ * @brief Runs the first pass over one file into its own section.
+ *
+ * @param context Pointer to the Context holding the preprocessed lines of the file.
+ * @param section Pointer to the Section of the file.
+ */
+void parse_section(Context *context, Section *section);
+
+/**
+ * @brief Joins the section of the next file onto the memory of the assembly.
+ *
+ * @param context Pointer to the Context holding the preprocessed lines of the file.
+ * @param section Pointer to the parsed Section of the file.
+ * @param mem Pointer to the Memory structure of the assembly.
+ */
+void join_section(Context *context, const Section *section, Memory *mem);
+
+/**
+ * @brief Frees the words, labels and errors held by a section.
+ *
+ * @param section Pointer to the Section to free.
+ */
+void free_section(Section *section);
+
+/**
+ * @brief Patches every word that refers to a label with the label's final address.
  *
- * @param filename The name of the file being processed.
  * @param mem Pointer to the Memory structure.
  */
-void second_parse(const char *filename, Memory *mem);
+void resolve_fixups(Memory *mem);
 
 /**
- * @brief Checks if the current line is an .entry directive.
+ * @brief Completes a single-pass assembly once every file has been parsed.
+ *
+ * Gives the data labels their final addresses and patches the references that could
+ * not be patched when their labels were declared.
  *
  * @param mem Pointer to the Memory structure.
- * @return true if the current line is an .entry directive, false otherwise.
+ * @return True if some label is undeclared or both external and an entry, so the
+ *         files must still be checked with second_parse to report it.
  */
-bool is_entry(Memory *mem);
+bool finish_single_pass(Memory *mem);
 
 /**
- * @brief Checks if the current line is an .extern directive.
+ * @brief Reports the label errors that belong to one file after the first pass.
  *
+ * @param filename The name of the file being processed.
  * @param mem Pointer to the Memory structure.
- * @return true if the current line is an .extern directive, false otherwise.
  */
-bool is_extern(Memory *mem);
+void second_parse(const char *filename, Memory *mem);
+
+/**
+ * @brief Checks if the statement starting at a token is an .entry directive.
+ *
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the first token of the statement.
+ * @return true if the statement contains an .entry directive, false otherwise.
+ */
+bool is_entry(const LineTokens *tokens, int index);
+
+/**
+ * @brief Checks if the statement starting at a token is an .extern directive.
+ *
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the first token of the statement.
+ * @return true if the statement contains an .extern directive, false otherwise.
+ */
+bool is_extern(const LineTokens *tokens, int index);
 
 /**
  * @brief Handles operands that involve both source and destination registers.
@@ -0,0 +1,35 @@
+/**
+ * @file pool.h
+ * @brief Declares a small pool of worker threads that runs independent tasks.
+ *
+ * The tasks are numbered from zero, and each worker repeatedly claims the next
+ * unclaimed number until none are left, so uneven tasks still keep every worker busy.
+ * The calling thread works alongside the pool and the call returns once every task
+ * has finished.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * @brief A task run by the pool.
+ *
+ * @param index The number of the task, from zero to the task count minus one.
+ * @param data The data pointer passed to run_in_parallel.
+ */
+typedef void (*PoolTask)(int index, void *data);
+
+/**
+ * @brief Runs a numbered set of tasks on a pool of threads and waits for all of them.
+ *
+ * If threads cannot be created, the remaining tasks run on the fewer threads that were,
+ * down to the calling thread alone, so every task always runs exactly once.
+ *
+ * @param task_count The number of tasks to run.
+ * @param thread_count The maximum number of threads to use, including the calling thread.
+ * @param task The function that runs one task.
+ * @param data Pointer passed to every task.
+ */
+void run_in_parallel(int task_count, int thread_count, PoolTask task, void *data);
+
+#endif /* POOL_H */
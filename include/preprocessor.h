@@ -2,33 +2,71 @@
 #define PREPROCESSOR_H
 
 #include "utils.h"
-#include <stdio.h>
+#include "reader.h"
 
 #define MAX_LINE_LENGTH 256
+#define MACRO_NAME_SIZE 32  /* Longest macro name plus its null terminator */
+
+struct AssemblerContext;
+struct ErrorList;
 
 /**
  * @brief Structure representing a macro in the assembly code.
  *
  * This structure holds the name of the macro, the lines of code that it
- * represents, and a pointer to the next macro in the list.
+ * represents, and a pointer to the previously defined macro. The lines point
+ * into the source buffer of the file that defined the macro.
  */
 typedef struct Macro {
-    char name[32];           /**< Name of the macro. */
-    char **lines;            /**< Array of lines that the macro expands to. */
+    char name[MACRO_NAME_SIZE]; /**< Name of the macro. */
+    const char **lines;      /**< Array of lines that the macro expands to. */
     int line_count;          /**< Number of lines in the macro. */
-    struct Macro *next;      /**< Pointer to the next macro in the list. */
+    unsigned long hash;      /**< Cached hash of the macro name. */
+    struct Macro *next;      /**< Pointer to the previously defined macro. */
 } Macro;
 
+/**
+ * @brief Open-addressing hash table of the macros defined during an assembly.
+ *
+ * The table is owned by the caller and shared by every file of the assembly, since a
+ * macro defined in one file is visible to the files after it.
+ */
+typedef struct MacroTable {
+    Macro **slots;           /**< Hash slots, NULL when empty. */
+    int capacity;            /**< Number of slots, always a power of two. */
+    int count;               /**< Number of distinct macro names stored. */
+    Macro *head;             /**< Most recently defined macro, chained to all earlier ones. */
+} MacroTable;
+
+/**
+ * @brief A line that may call a macro of an earlier file, recorded while preprocessing
+ * a file in isolation.
+ */
+typedef struct DeferredLine {
+    int index;               /**< Index of the line among the preprocessed lines. */
+    const char *name;        /**< The first token of the line, not null-terminated. */
+    size_t length;           /**< Length of the first token. */
+    unsigned long hash;      /**< Hash of the first token. */
+} DeferredLine;
+
 /**
  * @brief Structure representing the context during preprocessing.
  *
  * This structure stores the filename, the line number, and the preprocessed lines.
- * It also manages the capacity of the line buffer.
+ * It also manages the capacity of the line buffer. The preprocessed lines are not
+ * copies: they point into the source buffer of this file, or of the file that defined
+ * the macro they were expanded from, so every context must outlive the macro table
+ * and the parsing of every later file.
  */
 typedef struct {
     const char *filename;    /**< Name of the file being processed. */
     int line_number;         /**< Current line number being processed. */
-    char **preprocessed_lines; /**< Array of preprocessed lines. */
+    char *source;            /**< Contents of the file, null-terminated line by line. */
+    struct ErrorList *errors; /**< Error list that preprocessing errors are reported to. */
+    DeferredLine *deferred_lines; /**< Lines that may call macros of earlier files, when preprocessed in isolation. */
+    int deferred_count;      /**< Number of deferred lines. */
+    int deferred_capacity;   /**< Current capacity of the deferred lines array. */
+    const char **preprocessed_lines; /**< Array of preprocessed lines. */
     int line_count;          /**< Number of preprocessed lines. */
     int line_capacity;       /**< Current capacity of the preprocessed lines array. */
 } Context;
@@ -38,48 +76,90 @@ typedef struct {
  *
  * @param filename The name of the input file.
  * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param assembler Pointer to the assembler context holding the macros and errors of the assembly.
  * @return True if preprocessing was successful, false otherwise.
  */
-bool preprocess(const char *filename, Context *context);
+bool preprocess(const char *filename, Context *context, struct AssemblerContext *assembler);
 
 /**
- * @brief Adds a new macro to the macro list.
+ * @brief Preprocesses source text held in memory by expanding macros.
  *
+ * @param filename The name of the source, used to report errors.
+ * @param text The source text; it need not be null-terminated.
+ * @param length The number of bytes of text.
+ * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param assembler Pointer to the assembler context holding the macros and errors of the assembly.
+ * @return True if preprocessing was successful, false otherwise.
+ */
+bool preprocess_text(const char *filename, const char *text, size_t length, Context *context, struct AssemblerContext *assembler);
+
+/**
+ * @brief Preprocesses the input file on its own, without the macros of other files.
+ *
+ * Files preprocessed this way can be processed in any order or concurrently. Lines that
+ * may call a macro of an earlier file are recorded, and join_preprocessed_file completes
+ * them once the earlier files are known.
+ *
+ * @param filename The name of the input file.
+ * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param file_assembler Pointer to an assembler context of this file alone.
+ * @return True if preprocessing was successful, false otherwise.
+ */
+bool preprocess_isolated(const char *filename, Context *context, struct AssemblerContext *file_assembler);
+
+/**
+ * @brief Joins a file that was preprocessed on its own into the whole assembly.
+ *
+ * Files must be joined in order, after every earlier file has been joined.
+ *
+ * @param context Pointer to the Context of the file.
+ * @param file_assembler Pointer to the assembler context the file was preprocessed with; it is freed.
+ * @param assembler Pointer to the assembler context of the whole assembly.
+ * @return True if the file was joined, false if memory allocation failed.
+ */
+bool join_preprocessed_file(Context *context, struct AssemblerContext *file_assembler, struct AssemblerContext *assembler);
+
+/**
+ * @brief Initializes an empty macro table.
+ *
+ * @param table Pointer to the MacroTable to initialize.
+ */
+void init_macro_table(MacroTable *table);
+
+/**
+ * @brief Adds a new macro to the macro table, replacing any earlier macro with the same name.
+ *
+ * @param table Pointer to the macro table.
  * @param new_macro Pointer to the macro to be added.
+ * @return True if the macro was added, false if memory allocation failed.
  */
-void add_macro(Macro *new_macro);
+bool add_macro(MacroTable *table, Macro *new_macro);
 
 /**
  * @brief Finds a macro by its name.
  *
+ * @param table The macro table.
  * @param name The name of the macro to find.
  * @return Pointer to the macro if found, or NULL if not found.
  */
-Macro* find_macro(const char *name);
+Macro* find_macro(const MacroTable *table, const char *name);
 
 /**
  * @brief Processes a macro definition.
  *
- * @param input Pointer to the input file.
- * @param name The name of the macro being defined.
+ * @param input Pointer to the line reader of the input file, positioned after the macr line.
+ * @param name The name of the macro being defined, or NULL if the name is missing.
  * @param context Pointer to the Context structure for error reporting.
+ * @param macros Pointer to the macro table the macro is added to.
  * @return True if the macro was successfully processed, false otherwise.
  */
-bool process_macro_definition(FILE *input, char *name, Context *context);
-
-/**
- * @brief Expands macros in the source file.
- *
- * @param input Pointer to the input file.
- * @param context Pointer to the Context structure to store preprocessed lines.
- */
-void expand_macros(FILE *input, Context *context);
+bool process_macro_definition(LineReader *input, char *name, Context *context, MacroTable *macros);
 
 /**
  * @brief Adds a line of preprocessed code to the context.
  *
  * @param context Pointer to the Context structure containing preprocessed lines.
- * @param line The line to add.
+ * @param line The line to add, which must outlive the context.
  */
 void add_preprocessed_line(Context *context, const char *line);
 
@@ -91,8 +171,10 @@ void add_preprocessed_line(Context *context, const char *line);
 void free_context(Context *context);
 
 /**
- * @brief Frees the memory used by the macro list.
+ * @brief Frees the memory used by the macro table and all of its macros.
+ *
+ * @param table Pointer to the MacroTable to free.
  */
-void free_macros();
+void free_macros(MacroTable *table);
 
 #endif /* PREPROCESSOR_H */
@@ -0,0 +1,71 @@
+/**
+ * @file reader.h
+ * @brief Declares a line reader that loads a whole source file and walks it line by line.
+ *
+ * The file is read into memory with a few large block reads, and lines are found with
+ * memchr. Each line is null-terminated in place by overwriting its newline, so a line
+ * is handed out as a pointer into the file contents and reading it never allocates or
+ * copies. The contents can be released to the caller to keep those lines alive.
+ */
+
+#ifndef READER_H
+#define READER_H
+
+#include <stddef.h>
+#include "utils.h"
+
+/**
+ * @brief Structure to represent a source file being read line by line.
+ */
+typedef struct LineReader {
+    char *data;               /**< The whole file contents, plus a terminating null byte */
+    size_t length;            /**< Number of bytes in the file */
+    size_t position;          /**< Offset of the next line */
+} LineReader;
+
+/**
+ * @brief Reads a whole file into a line reader.
+ *
+ * @param reader Pointer to the LineReader to fill.
+ * @param path The path of the file to read.
+ * @return True if the file was read, false if it could not be opened or memory allocation failed.
+ */
+bool open_line_reader(LineReader *reader, const char *path);
+
+/**
+ * @brief Fills a line reader with a copy of source text held in memory.
+ *
+ * @param reader Pointer to the LineReader to fill.
+ * @param text The source text; it need not be null-terminated.
+ * @param length The number of bytes of text.
+ * @return True if the text was copied, false if memory allocation failed.
+ */
+bool open_line_buffer(LineReader *reader, const char *text, size_t length);
+
+/**
+ * @brief Reads the next line of the file, null-terminating it in place.
+ *
+ * The returned string points into the file contents, so it stays valid until the
+ * reader is closed, or for as long as the caller keeps the released contents.
+ *
+ * @param reader Pointer to the LineReader.
+ * @return The null-terminated line without its newline, or NULL at the end of the file.
+ */
+char* read_next_line(LineReader *reader);
+
+/**
+ * @brief Hands the file contents over to the caller and empties the reader.
+ *
+ * @param reader Pointer to the LineReader.
+ * @return The file contents, which the caller must free.
+ */
+char* release_line_reader(LineReader *reader);
+
+/**
+ * @brief Frees the file contents held by a line reader.
+ *
+ * @param reader Pointer to the LineReader to close.
+ */
+void close_line_reader(LineReader *reader);
+
+#endif /* READER_H */
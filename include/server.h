@@ -0,0 +1,48 @@
+/**
+ * @file server.h
+ * @brief Declares the assembler server and the client that sends it builds.
+ *
+ * A server listens on a Unix domain socket and builds the sources each client sends,
+ * so the work of starting the assembler is paid once instead of on every run. A
+ * request carries the name and contents of every source file, and the response
+ * carries the BuildResult, which the client reports just as a local build would be.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "utils.h"
+#include "build.h"
+
+#define SERVER_MAGIC "ASM2"                  /* First bytes of every request */
+#define MAX_MESSAGE_LENGTH (256UL << 20)     /* Upper limit of any length field of a message */
+#define MAX_REQUEST_FILES 4096               /* Upper limit of the number of files in a request */
+#define SERVER_TIMEOUT_SECONDS 5             /* Longest the server waits on one read or write of a client */
+#define CLIENT_TIMEOUT_SECONDS 30            /* Longest a client waits on one read or write, including the build */
+
+/**
+ * @brief Serves builds on a Unix domain socket until the process is stopped.
+ *
+ * Requests are built one at a time, in the order their connections are accepted.
+ *
+ * @param socket_path The path of the socket; an existing file at the path is replaced.
+ * @param jobs The number of threads to parse each build with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ * @return False if the socket could not be set up; otherwise the function does not return.
+ */
+bool serve(const char *socket_path, int jobs, bool single_pass);
+
+/**
+ * @brief Has a server build source files read from disk.
+ *
+ * @param socket_path The path of the server's socket.
+ * @param file_count The number of files.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param max_errors The number of errors after which the build stops reporting errors, or 0 for no limit.
+ * @param result Pointer to the initialized BuildResult to fill.
+ * @return True if the server built the files, false if the files could not be read or
+ *         the server could not be reached; the result is left empty in that case.
+ */
+bool request_build(const char *socket_path, int file_count, const char **filenames, int max_errors, BuildResult *result);
+
+#endif /* SERVER_H */
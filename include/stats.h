@@ -0,0 +1,151 @@
+/**
+ * @file stats.h
+ * @brief Declares the per-stage timers and counters reported by the --stats option.
+ *
+ * Stage timers accumulate wall time between begin_stage and end_stage calls, and the
+ * counters are bumped from wherever the counted work happens. Heap allocations are
+ * counted by routing them through counted_malloc, counted_calloc and counted_realloc.
+ *
+ * The timers and counters live in a caller-owned Stats, which is attached to the
+ * thread that accumulates into it. Worker threads get a Stats of their own that is
+ * merged into the Stats of the thread that started them once they are joined, so
+ * bumping a counter never takes a lock. Stage timers are only used by the main thread.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include "utils.h"
+
+/**
+ * @enum Stage
+ * @brief The timed stages of an assembler run.
+ */
+typedef enum {
+    STAGE_PREPROCESS,
+    STAGE_FIRST_PASS,
+    STAGE_ADJUST_ADDRESSES,
+    STAGE_SECOND_PASS,
+    STAGE_OUTPUT,
+    STAGE_COUNT /* Number of stages */
+} Stage;
+
+/**
+ * @enum Counter
+ * @brief The counters reported alongside the stage timings.
+ */
+typedef enum {
+    COUNTER_LINES,
+    COUNTER_WORDS,
+    COUNTER_LABELS,
+    COUNTER_LABEL_LOOKUPS,
+    COUNTER_MACRO_EXPANSIONS,
+    COUNTER_MALLOCS,
+    COUNTER_BYTES_WRITTEN,
+    COUNTER_COUNT /* Number of counters */
+} Counter;
+
+/**
+ * @brief The stage timings and counters accumulated by one thread.
+ */
+typedef struct Stats {
+    double stage_seconds[STAGE_COUNT];     /**< Accumulated wall time of each stage, in seconds */
+    double stage_start[STAGE_COUNT];       /**< Start time of each stage that is being timed */
+    unsigned long counters[COUNTER_COUNT]; /**< Current value of each counter */
+} Stats;
+
+/**
+ * @brief Initializes a Stats with zero timings and counters.
+ *
+ * @param stats Pointer to the Stats to initialize.
+ */
+void init_stats(Stats *stats);
+
+/**
+ * @brief Turns on stage timing and counting, accumulating into the given Stats.
+ *
+ * Must be called before any other thread is started.
+ *
+ * @param stats The Stats the calling thread accumulates into; the report is printed by print_stats.
+ */
+void enable_stats(Stats *stats);
+
+/**
+ * @brief Makes the calling thread accumulate into the given Stats.
+ *
+ * @param stats The Stats of the calling thread.
+ */
+void attach_stats(Stats *stats);
+
+/**
+ * @brief Returns the Stats the calling thread accumulates into.
+ *
+ * @return The Stats of the calling thread, or NULL if stats are off or none is attached.
+ */
+Stats* thread_stats(void);
+
+/**
+ * @brief Adds the counters of one Stats to another.
+ *
+ * @param into The Stats to add to.
+ * @param from The Stats whose counters are added.
+ */
+void merge_stats(Stats *into, const Stats *from);
+
+/**
+ * @brief Starts timing a stage.
+ *
+ * @param stage The stage being entered.
+ */
+void begin_stage(Stage stage);
+
+/**
+ * @brief Stops timing a stage and adds the elapsed wall time to its total.
+ *
+ * @param stage The stage being left.
+ */
+void end_stage(Stage stage);
+
+/**
+ * @brief Adds an amount to a counter.
+ *
+ * @param counter The counter to increase.
+ * @param amount The amount to add.
+ */
+void add_to_counter(Counter counter, unsigned long amount);
+
+/**
+ * @brief Prints the stage timings, counters and peak memory use to stderr if stats are enabled.
+ *
+ * @param stats The Stats to report.
+ */
+void print_stats(const Stats *stats);
+
+/**
+ * @brief Allocates memory with malloc and counts the allocation.
+ *
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* counted_malloc(size_t size);
+
+/**
+ * @brief Allocates zeroed memory with calloc and counts the allocation.
+ *
+ * @param count The number of elements to allocate.
+ * @param size The size of each element.
+ * @return A pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* counted_calloc(size_t count, size_t size);
+
+/**
+ * @brief Resizes memory with realloc and counts the allocation.
+ *
+ * @param ptr The memory to resize, or NULL.
+ * @param size The new size in bytes.
+ * @return A pointer to the resized memory, or NULL if allocation fails.
+ */
+void* counted_realloc(void *ptr, size_t size);
+
+#endif /* STATS_H */
@@ -0,0 +1,73 @@
+/**
+ * @file symbol.h
+ * @brief Provides the interface for interning symbol names as small integer IDs.
+ *
+ * Each distinct name is copied once, the first time it is interned, and gets the next
+ * free ID. Interning the same name again returns the same ID, so names can be carried
+ * and compared as IDs, and each ID maps back to one shared copy of its name.
+ */
+
+#ifndef SYMBOL_H
+#define SYMBOL_H
+
+#include "utils.h"
+#include "arena.h"
+
+#define NO_SYMBOL (-1)  /* ID returned when a name is not interned */
+
+/**
+ * @brief Open-addressing hash table from names to symbol IDs.
+ */
+typedef struct SymbolTable {
+    Arena *arena;             /**< Arena the names are copied into */
+    char **names;             /**< Name of each symbol, indexed by ID */
+    unsigned long *hashes;    /**< Hash of each symbol name, indexed by ID */
+    int count;                /**< Number of symbols, which is also the next ID */
+    int names_capacity;       /**< Number of names allocated */
+    int *slots;               /**< Hash slots holding IDs, NO_SYMBOL when empty */
+    int capacity;             /**< Number of slots, always a power of two */
+} SymbolTable;
+
+/**
+ * @brief Initializes an empty symbol table.
+ *
+ * @param table Pointer to the SymbolTable to initialize.
+ * @param arena The arena that interned names are copied into.
+ */
+void init_symbol_table(SymbolTable *table, Arena *arena);
+
+/**
+ * @brief Returns the ID of a name, interning it first if it has not been seen.
+ *
+ * @param table Pointer to the symbol table.
+ * @param name The name to intern.
+ * @return The ID of the name, or NO_SYMBOL if memory allocation fails.
+ */
+int intern_symbol(SymbolTable *table, const char *name);
+
+/**
+ * @brief Looks up the ID of a name without interning it.
+ *
+ * @param table Pointer to the symbol table.
+ * @param name The name to look up.
+ * @return The ID of the name, or NO_SYMBOL if it has not been interned.
+ */
+int find_symbol(const SymbolTable *table, const char *name);
+
+/**
+ * @brief Returns the interned copy of the name of a symbol.
+ *
+ * @param table Pointer to the symbol table.
+ * @param id The ID of the symbol.
+ * @return The name, which lives as long as the table's arena.
+ */
+char* symbol_name(const SymbolTable *table, int id);
+
+/**
+ * @brief Frees the IDs and slots of the symbol table; the names are released with their arena.
+ *
+ * @param table Pointer to the SymbolTable to free.
+ */
+void free_symbol_table(SymbolTable *table);
+
+#endif /* SYMBOL_H */
@@ -9,14 +9,6 @@ typedef int bool;
 #define true 1
 #define false 0
 
-/**
- * @brief Reads a line of text from a file.
- *
- * @param file The file stream to read from.
- * @return A pointer to the dynamically allocated string containing the line, or NULL if EOF is reached.
- */
-char* read_line(FILE *file);
-
 /**
  * @brief Trims leading and trailing whitespace from a string.
  *
@@ -33,4 +25,12 @@ char* trim_whitespace(char *str);
  */
 char* str_duplicate(const char *s);
 
+/**
+ * @brief Computes the FNV-1a hash of a string.
+ *
+ * @param str The string to hash.
+ * @return The hash of the string.
+ */
+unsigned long hash_string(const char *str);
+
 #endif /* UTILS_H */
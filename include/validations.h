@@ -4,6 +4,7 @@
 #include "utils.h"
 #include "label.h"
 #include "memory.h"
+#include "operations.h"
 
 /**
  * @brief Validates the name of a macro.
@@ -47,16 +48,24 @@ bool validate_string(char *string);
  */
 bool validate_operand(char *operand, Memory *memory);
 
+/**
+ * @brief Checks if a label name is a reserved word (an operation mnemonic or a directive).
+ *
+ * @param label_name The label name to check.
+ * @return True if the label name is reserved, false otherwise.
+ */
+bool is_reserved_word(const char *label_name);
+
 /**
  * @brief Validates an instruction.
  *
- * @param operation The operation (mnemonic) of the instruction.
+ * @param operation The operation keyword of the instruction, or NULL if the operation is unknown.
  * @param dest_mode The addressing mode of the destination operand.
  * @param source_mode The addressing mode of the source operand.
  * @param memory Pointer to the Memory structure for context.
  * @return True if the instruction is valid, false otherwise.
  */
-bool validate_instruction(char *operation, int dest_mode, int source_mode, Memory *memory);
+bool validate_instruction(const Keyword *operation, int dest_mode, int source_mode, Memory *memory);
 
 /**
  * @brief Validates a label declaration.
@@ -0,0 +1,12 @@
+; Macro Blank Line Test
+mov r1, r2
+
+macr m1
+inc r3
+
+endmacr
+
+.data 6
+m1
+bad_token
+stop
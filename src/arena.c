@@ -0,0 +1,112 @@
+/**
+ * @file arena.c
+ * @brief Implements the chunked bump allocator used for per-assembly objects.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+#include "stats.h"
+
+#define ARENA_CHUNK_SIZE 65536
+
+/**
+ * @brief Union of the most strictly aligned basic types, used to align allocations.
+ */
+typedef union ArenaAlign {
+    long l;
+    double d;
+    void *p;
+} ArenaAlign;
+
+#define ARENA_ALIGNMENT sizeof(ArenaAlign)
+#define ALIGN_UP(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+#define CHUNK_HEADER_SIZE ALIGN_UP(sizeof(ArenaChunk))
+
+/**
+ * @brief Initializes an empty arena.
+ *
+ * @param arena Pointer to the Arena to initialize.
+ */
+void init_arena(Arena *arena) {
+    arena->chunks = NULL;
+    arena->chunk_count = 0;
+    arena->allocation_count = 0;
+    arena->bytes_used = 0;
+}
+
+/**
+ * @brief Allocates a block from the arena, suitably aligned for any object.
+ *
+ * A new chunk is chained in when the current one cannot fit the request; requests
+ * larger than a chunk get a chunk of their own.
+ *
+ * @param arena Pointer to the Arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the block, or NULL if memory allocation fails.
+ */
+void* arena_alloc(Arena *arena, size_t size) {
+    ArenaChunk *chunk = arena->chunks;
+    size_t capacity;
+    char *block;
+
+    size = ALIGN_UP(size == 0 ? 1 : size);
+    if (chunk == NULL || chunk->capacity - chunk->used < size) {
+        capacity = (size > ARENA_CHUNK_SIZE) ? size : ARENA_CHUNK_SIZE;
+        chunk = (ArenaChunk *)counted_malloc(CHUNK_HEADER_SIZE + capacity);
+        if (chunk == NULL) {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        chunk->capacity = capacity;
+        chunk->used = 0;
+        arena->chunks = chunk;
+        arena->chunk_count++;
+    }
+
+    block = (char *)chunk + CHUNK_HEADER_SIZE + chunk->used;
+    chunk->used += size;
+    arena->allocation_count++;
+    arena->bytes_used += size;
+    return block;
+}
+
+/**
+ * @brief Copies a string into the arena.
+ *
+ * @param arena Pointer to the Arena to allocate from.
+ * @param str The string to copy.
+ * @return A pointer to the copy, or NULL if the input is NULL or memory allocation fails.
+ */
+char* arena_strdup(Arena *arena, const char *str) {
+    size_t length;
+    char *copy;
+
+    if (str == NULL) {
+        return NULL;
+    }
+
+    length = strlen(str) + 1;
+    copy = (char *)arena_alloc(arena, length);
+    if (copy != NULL) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+/**
+ * @brief Releases every chunk of the arena at once and resets it to empty.
+ *
+ * @param arena Pointer to the Arena to free.
+ */
+void free_arena(Arena *arena) {
+    ArenaChunk *chunk = arena->chunks;
+    ArenaChunk *next;
+
+    while (chunk != NULL) {
+        next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    init_arena(arena);
+}
@@ -3,6 +3,7 @@
 ** Responsible for initializing memory and handling the overall flow. 
 */
 
+#include <stdlib.h>
 #include <string.h>
 #include "utils.h"
 #include "error.h"
@@ -10,80 +11,246 @@
 #include "memory.h"
 #include "parser.h"
 #include "file_manager.h"
+#include "pool.h"
+#include "stats.h"
+
+/**
+ * @brief Initializes an assembler context with no errors and no macros.
+ *
+ * @param assembler Pointer to the AssemblerContext to initialize.
+ */
+void init_assembler_context(AssemblerContext *assembler) {
+    init_error_handling(&assembler->errors);
+    init_macro_table(&assembler->macros);
+    assembler->warnings = NULL;
+    assembler->single_pass = false;
+}
+
+/**
+ * @brief Frees the errors and macros held by an assembler context.
+ *
+ * The contexts of the preprocessed files may be freed before or after this, since the
+ * macros only point into their source buffers.
+ *
+ * @param assembler Pointer to the AssemblerContext to free.
+ */
+void free_assembler_context(AssemblerContext *assembler) {
+    free_macros(&assembler->macros);
+    free_errors(&assembler->errors);
+}
+
+/**
+ * @brief The files being preprocessed in parallel.
+ */
+typedef struct PreprocessJob {
+    const char **filenames;       /**< The file names */
+    Context *contexts;            /**< The context of each file */
+    AssemblerContext *assemblers; /**< The private assembler context of each file */
+} PreprocessJob;
+
+/**
+ * @brief Preprocesses one file of a parallel job in isolation.
+ *
+ * @param index The index of the file.
+ * @param data Pointer to the PreprocessJob.
+ */
+static void preprocess_task(int index, void *data) {
+    PreprocessJob *job = (PreprocessJob *)data;
+    preprocess_isolated(job->filenames[index], &job->contexts[index], &job->assemblers[index]);
+}
 
 /**
  * @brief Preprocesses all source files before assembly.
  *
- * This function iterates through each source file, invoking the preprocessing step
- * for each file. The results are stored in the provided contexts.
+ * With one job, the files are preprocessed one after another and share the assembly's
+ * macro table as they go. With more, each file is preprocessed on a worker thread with
+ * its own macro table and error list, and the files are then joined in order, so macros
+ * of earlier files are still expanded and errors are still reported in file order.
  *
  * @param file_count The number of files to preprocess.
  * @param filenames The array of file names to preprocess.
  * @param contexts The array of contexts to store preprocessing results.
+ * @param assembler The assembler context collecting the macros and errors of all the files.
+ * @param jobs The number of threads to preprocess with.
  * @return true if all files were successfully preprocessed, false otherwise.
  */
-bool preprocess_all_files(int file_count, const char **filenames, Context *contexts) {
+bool preprocess_all_files(int file_count, const char **filenames, Context *contexts, AssemblerContext *assembler, int jobs) {
     int i;
     bool success = true;
-    for (i = 0; i < file_count; i++) {
-        if (!preprocess(filenames[i], &contexts[i])) {
-            success = false;
+    PreprocessJob job;
+
+    begin_stage(STAGE_PREPROCESS);
+    job.assemblers = NULL;
+    if (jobs > 1 && file_count > 1) {
+        job.assemblers = (AssemblerContext *)counted_malloc(file_count * sizeof(AssemblerContext));
+    }
+
+    if (job.assemblers == NULL) {
+        for (i = 0; i < file_count; i++) {
+            if (!preprocess(filenames[i], &contexts[i], assembler)) {
+                success = false;
+            }
         }
+    } else {
+        job.filenames = filenames;
+        job.contexts = contexts;
+        for (i = 0; i < file_count; i++) {
+            init_assembler_context(&job.assemblers[i]);
+            job.assemblers[i].errors.limit = assembler->errors.limit;
+        }
+
+        run_in_parallel(file_count, jobs, preprocess_task, &job);
+
+        for (i = 0; i < file_count; i++) {
+            if (!join_preprocessed_file(&contexts[i], &job.assemblers[i], assembler)) {
+                success = false;
+            }
+        }
+        free(job.assemblers);
+
+        /* A file fails exactly when it reports an error */
+        success = success && !has_errors(&assembler->errors);
     }
+    end_stage(STAGE_PREPROCESS);
     return success;
 }
 
 /**
- * @brief Performs the assembly process on the given files.
+ * @brief The files whose first pass runs in parallel.
+ */
+typedef struct ParseJob {
+    Context *contexts;            /**< The context of each file */
+    Section *sections;            /**< The section each file is parsed into */
+} ParseJob;
+
+/**
+ * @brief Runs the first pass over one file of a parallel job.
  *
- * This function orchestrates the entire assembly process, including parsing, label handling,
- * and memory management. It processes each file in two passes and handles the output of the
- * assembled files.
+ * @param index The index of the file.
+ * @param data Pointer to the ParseJob.
+ */
+static void parse_task(int index, void *data) {
+    ParseJob *job = (ParseJob *)data;
+    parse_section(&job->contexts[index], &job->sections[index]);
+}
+
+/**
+ * @brief Runs the first pass over all files.
+ *
+ * With one job, the files are parsed one after another straight into the memory. With
+ * more, each file is parsed on a worker thread into its own section, and the sections
+ * are then joined in file order. A run with an error limit is parsed serially, since it
+ * stops at the line where the limit is reached.
+ *
+ * @param file_count The number of files to parse.
+ * @param contexts The array of contexts holding the preprocessed lines of each file.
+ * @param assembler The assembler context holding the macros.
+ * @param mem Pointer to the Memory structure of the assembly.
+ * @param jobs The number of threads to parse with.
+ */
+static void parse_all_files(int file_count, Context *contexts, AssemblerContext *assembler, Memory *mem, int jobs) {
+    int i;
+    ParseJob job;
+
+    job.sections = NULL;
+    if (jobs > 1 && file_count > 1 && assembler->errors.limit == 0) {
+        job.sections = (Section *)counted_malloc(file_count * sizeof(Section));
+    }
+
+    if (job.sections == NULL) {
+        for (i = 0; i < file_count; i++) {
+            parse_context(&contexts[i], mem);
+        }
+    } else {
+        job.contexts = contexts;
+        for (i = 0; i < file_count; i++) {
+            init_section(&job.sections[i], &assembler->macros);
+        }
+
+        run_in_parallel(file_count, jobs, parse_task, &job);
+
+        for (i = 0; i < file_count; i++) {
+            join_section(&contexts[i], &job.sections[i], mem);
+            free_section(&job.sections[i]);
+        }
+        free(job.sections);
+    }
+
+    for (i = 0; i < file_count; i++) {
+        add_to_counter(COUNTER_LINES, contexts[i].line_count);
+    }
+}
+
+/**
+ * @brief Assembles the given files into the contents of their output files.
+ *
+ * This function runs both passes over the preprocessed lines held by the contexts,
+ * including parsing, label handling and memory management, and formats the output
+ * files in memory if no errors were found. Nothing is read from or written to disk.
  *
  * @param file_count The number of files to assemble.
- * @param filenames The array of file names to assemble.
+ * @param contexts The array of contexts holding the preprocessed lines of each file.
+ * @param assembler The assembler context holding the macros and collecting the errors.
+ * @param jobs The number of threads to run the first pass with.
+ * @param output Pointer to the initialized OutputFiles that receive the contents.
  * @return true if assembly was successful for all files, false otherwise.
  */
-bool assemble(int file_count, const char **filenames) {
-    ListNode *node;
+bool assemble_to_output(int file_count, Context *contexts, AssemblerContext *assembler, int jobs, OutputFiles *output) {
     Label *label;
     int i;
     bool success = true;
     Memory mem;
 
     initialize_memory(&mem);
+    mem.macros = &assembler->macros;
+    mem.errors = &assembler->errors;
+    mem.warnings = assembler->warnings;
+    mem.single_pass = assembler->single_pass;
 
     /* First parse */
-    for (i = 0; i < file_count; i++) {
-        parse_file(filenames[i], &mem);
-    }
+    begin_stage(STAGE_FIRST_PASS);
+    parse_all_files(file_count, contexts, assembler, &mem, jobs);
+    end_stage(STAGE_FIRST_PASS);
+    add_to_counter(COUNTER_WORDS, mem.instructions.count + mem.data.count);
+    add_to_counter(COUNTER_LABELS, mem.labels.count);
 
-    /* Adjust label and node addresses */
-    for (label = mem.label_list; label != NULL; label = label->next) {
-        if (!label->is_instruction) {
-            label->address = (label->address == 0) ? 0 : (label->address + mem.IC);
-        } else {
-            label->address += 100;
+    if (mem.single_pass) {
+        /* Only data labels and undeclared labels are left to patch; files are checked only if a label is unresolved */
+        begin_stage(STAGE_SECOND_PASS);
+        if (finish_single_pass(&mem)) {
+            for (i = 0; i < file_count; i++) {
+                second_parse(contexts[i].filename, &mem);
+            }
         }
-    }
-
-    for (node = mem.instructionList; node != NULL; node = node->next) {
-        node->address += 100;
-    }
-    for (node = mem.dataList; node != NULL; node = node->next) {
-        node->address += mem.IC;
-    }
+        end_stage(STAGE_SECOND_PASS);
+    } else {
+        /* Adjust label addresses; word addresses are derived from their indexes on output */
+        begin_stage(STAGE_ADJUST_ADDRESSES);
+        for (label = mem.labels.head; label != NULL; label = label->next) {
+            if (!label->is_instruction) {
+                label->address = (label->address == 0) ? 0 : (label->address + mem.IC);
+            } else {
+                label->address += LOAD_ADDRESS;
+            }
+        }
+        end_stage(STAGE_ADJUST_ADDRESSES);
 
-    /* Second parse */
-    for (i = 0; i < file_count; i++) {
-        second_parse(filenames[i], &mem);
+        /* Second parse: patch label references once, then check each file's labels */
+        begin_stage(STAGE_SECOND_PASS);
+        resolve_fixups(&mem);
+        for (i = 0; i < file_count; i++) {
+            second_parse(contexts[i].filename, &mem);
+        }
+        end_stage(STAGE_SECOND_PASS);
     }
 
-    /* Check for errors and write output files */
-    if(has_errors()) {
+    /* Check for errors and format the output files */
+    if(has_errors(&assembler->errors)) {
+        success = false;
+    } else if (!format_output_files(&mem, output)) {
+        /* A truncated buffer must not be written as a valid-looking output file */
+        add_error(&assembler->errors, ERR_MEMORY_ALLOCATION_FAILED, "", 0, NULL);
         success = false;
-    } else {
-        write_output_files(filenames, file_count, &mem);
     }
 
     /* Clear memory */
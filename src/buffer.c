@@ -0,0 +1,151 @@
+/**
+ * @file buffer.c
+ * @brief Implements the growable byte buffer used to assemble output files in memory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffer.h"
+#include "stats.h"
+
+#define INITIAL_BUFFER_CAPACITY 4096
+#define TEMP_SUFFIX ".tmp"
+
+/**
+ * @brief Initializes an empty buffer.
+ *
+ * @param buffer Pointer to the Buffer to initialize.
+ */
+void init_buffer(Buffer *buffer) {
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+}
+
+/**
+ * @brief Appends bytes to the buffer, doubling its capacity when full.
+ *
+ * @param buffer Pointer to the Buffer to append to.
+ * @param bytes The bytes to append.
+ * @param length The number of bytes to append.
+ * @return True if the bytes were appended, false if memory allocation failed.
+ */
+bool buffer_append(Buffer *buffer, const char *bytes, size_t length) {
+    size_t capacity;
+    char *data;
+
+    if (length == 0) {
+        return true;
+    }
+    if (buffer->length + length > buffer->capacity) {
+        capacity = (buffer->capacity == 0) ? INITIAL_BUFFER_CAPACITY : buffer->capacity;
+        while (capacity < buffer->length + length) {
+            capacity *= 2;
+        }
+        data = (char *)counted_realloc(buffer->data, capacity);
+        if (data == NULL) {
+            return false;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    memcpy(buffer->data + buffer->length, bytes, length);
+    buffer->length += length;
+    return true;
+}
+
+/**
+ * @brief Appends a null-terminated string to the buffer.
+ *
+ * @param buffer Pointer to the Buffer to append to.
+ * @param str The string to append.
+ * @return True if the string was appended, false if memory allocation failed.
+ */
+bool buffer_append_string(Buffer *buffer, const char *str) {
+    return buffer_append(buffer, str, strlen(str));
+}
+
+/**
+ * @brief Writes the buffer to a file atomically.
+ *
+ * The stream is left unbuffered so the whole buffer reaches the file in a single
+ * write, and the temporary file is only renamed into place once it is complete.
+ *
+ * @param buffer Pointer to the Buffer to write.
+ * @param path The path of the file to create or replace.
+ * @return True if the file was written and renamed successfully, false otherwise.
+ */
+bool write_buffer_to_file(const Buffer *buffer, const char *path) {
+    bool success = true;
+    char *temp_path;
+    FILE *file;
+
+    temp_path = (char *)counted_malloc(strlen(path) + sizeof(TEMP_SUFFIX));
+    if (temp_path == NULL) {
+        return false;
+    }
+    strcpy(temp_path, path);
+    strcat(temp_path, TEMP_SUFFIX);
+
+    file = fopen(temp_path, "w");
+    if (file == NULL) {
+        free(temp_path);
+        return false;
+    }
+    setvbuf(file, NULL, _IONBF, 0);
+
+    if (buffer->length > 0 && fwrite(buffer->data, 1, buffer->length, file) != buffer->length) {
+        success = false;
+    }
+    if (fclose(file) != 0) {
+        success = false;
+    }
+
+    if (success && rename(temp_path, path) != 0) {
+        success = false;
+    }
+    if (success) {
+        add_to_counter(COUNTER_BYTES_WRITTEN, buffer->length);
+    } else {
+        remove(temp_path);
+    }
+
+    free(temp_path);
+    return success;
+}
+
+/**
+ * @brief Null-terminates the buffer and hands its contents over to the caller, emptying it.
+ *
+ * An empty buffer is released as an empty string, so the result is only NULL when
+ * memory allocation fails.
+ *
+ * @param buffer Pointer to the Buffer to release.
+ * @param length Pointer that receives the number of bytes before the terminator.
+ * @return The contents, which the caller must free, or NULL if memory allocation failed.
+ */
+char* release_buffer(Buffer *buffer, size_t *length) {
+    char *data;
+
+    *length = buffer->length;
+    if (!buffer_append(buffer, "", 1)) {
+        free_buffer(buffer);
+        *length = 0;
+        return NULL;
+    }
+    data = buffer->data;
+    init_buffer(buffer);
+    return data;
+}
+
+/**
+ * @brief Frees the memory held by the buffer and resets it to empty.
+ *
+ * @param buffer Pointer to the Buffer to free.
+ */
+void free_buffer(Buffer *buffer) {
+    free(buffer->data);
+    init_buffer(buffer);
+}
@@ -0,0 +1,410 @@
+/**
+ * @file build.c
+ * @brief Implements the in-memory build of a set of source files and the reporting of its result.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "build.h"
+#include "assembler.h"
+#include "preprocessor.h"
+#include "error.h"
+#include "stats.h"
+
+/**
+ * @brief Initializes an empty build result.
+ *
+ * @param result Pointer to the BuildResult to initialize.
+ */
+void init_build_result(BuildResult *result) {
+    result->preprocessed = false;
+    result->assembled = false;
+    result->file_count = 0;
+    result->preprocessed_files = NULL;
+    init_output_files(&result->output);
+    init_buffer(&result->warnings);
+    init_buffer(&result->diagnostics);
+}
+
+/**
+ * @brief Assembles preprocessed files and collects the result of the build.
+ *
+ * The .am contents are taken before assembling, and the files are then assembled under
+ * their .am names, which is how errors found after preprocessing name the file.
+ *
+ * @param file_count The number of files.
+ * @param contexts The contexts of the files, preprocessed into the assembler context.
+ * @param assembler The assembler context holding the macros and errors of the build.
+ * @param preprocessed Whether every file preprocessed without errors.
+ * @param jobs The number of threads to parse with.
+ * @param result Pointer to the BuildResult to fill.
+ */
+static void finish_build(int file_count, Context *contexts, AssemblerContext *assembler, bool preprocessed, int jobs, BuildResult *result) {
+    int i;
+    char **am_names = NULL;
+
+    result->file_count = file_count;
+    result->preprocessed = preprocessed;
+
+    if (preprocessed) {
+        result->preprocessed_files = (Buffer *)counted_malloc((file_count > 0 ? file_count : 1) * sizeof(Buffer));
+        am_names = (char **)counted_calloc(file_count > 0 ? file_count : 1, sizeof(char *));
+        if (result->preprocessed_files == NULL || am_names == NULL) {
+            add_error(&assembler->errors, ERR_MEMORY_ALLOCATION_FAILED, "", 0, NULL);
+            free(result->preprocessed_files);
+            result->preprocessed_files = NULL;
+            result->preprocessed = false;
+        }
+    }
+
+    if (result->preprocessed) {
+        for (i = 0; i < file_count; i++) {
+            init_buffer(&result->preprocessed_files[i]);
+            format_preprocessed_file(&contexts[i], &result->preprocessed_files[i]);
+
+            am_names[i] = (char *)counted_malloc(strlen(contexts[i].filename) + 4);  /* Room to append ".am" */
+            if (am_names[i] != NULL) {
+                strcpy(am_names[i], contexts[i].filename);
+                fix_filenames((const char **)&am_names[i], 1);
+                contexts[i].filename = am_names[i];
+            }
+        }
+
+        assembler->warnings = &result->warnings;
+        result->assembled = assemble_to_output(file_count, contexts, assembler, jobs, &result->output);
+        assembler->warnings = NULL;
+    }
+
+    format_errors(&assembler->errors, &result->diagnostics);
+
+    if (am_names != NULL) {
+        for (i = 0; i < file_count; i++) {
+            free(am_names[i]);
+        }
+        free(am_names);
+    }
+}
+
+/**
+ * @brief Builds source files read from disk.
+ *
+ * @param file_count The number of files.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param jobs The number of threads to preprocess and parse with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ * @param max_errors The number of errors after which the build stops reporting errors, or 0 for no limit.
+ * @param result Pointer to the initialized BuildResult to fill.
+ */
+void build_files(int file_count, const char **filenames, int jobs, bool single_pass, int max_errors, BuildResult *result) {
+    int i;
+    bool preprocessed;
+    Context *contexts;
+    AssemblerContext assembler;
+
+    contexts = (Context *)counted_malloc(file_count * sizeof(Context));
+    if (contexts == NULL) {
+        fprintf(stderr, "Failed to allocate memory for contexts.\n");
+        return;
+    }
+
+    init_assembler_context(&assembler);
+    assembler.single_pass = single_pass;
+    assembler.errors.limit = max_errors;
+    preprocessed = preprocess_all_files(file_count, filenames, contexts, &assembler, jobs);
+    finish_build(file_count, contexts, &assembler, preprocessed, jobs, result);
+
+    for (i = 0; i < file_count; i++) {
+        free_context(&contexts[i]);
+    }
+    free(contexts);
+    free_assembler_context(&assembler);
+}
+
+/**
+ * @brief Builds sources whose contents are already in memory.
+ *
+ * The sources are preprocessed one after another into a shared macro table, just as
+ * files read from disk are.
+ *
+ * @param file_count The number of sources.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param texts The contents of each source; they need not be null-terminated.
+ * @param lengths The number of bytes of each source.
+ * @param jobs The number of threads to parse with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ * @param max_errors The number of errors after which the build stops reporting errors, or 0 for no limit.
+ * @param result Pointer to the initialized BuildResult to fill.
+ */
+void build_sources(int file_count, const char **filenames, const char **texts, const size_t *lengths, int jobs, bool single_pass, int max_errors, BuildResult *result) {
+    int i;
+    bool preprocessed = true;
+    Context *contexts;
+    AssemblerContext assembler;
+
+    contexts = (Context *)counted_malloc((file_count > 0 ? file_count : 1) * sizeof(Context));
+    if (contexts == NULL) {
+        fprintf(stderr, "Failed to allocate memory for contexts.\n");
+        return;
+    }
+
+    init_assembler_context(&assembler);
+    assembler.single_pass = single_pass;
+    assembler.errors.limit = max_errors;
+    begin_stage(STAGE_PREPROCESS);
+    for (i = 0; i < file_count; i++) {
+        if (!preprocess_text(filenames[i], texts[i], lengths[i], &contexts[i], &assembler)) {
+            preprocessed = false;
+        }
+    }
+    end_stage(STAGE_PREPROCESS);
+    finish_build(file_count, contexts, &assembler, preprocessed, jobs, result);
+
+    for (i = 0; i < file_count; i++) {
+        free_context(&contexts[i]);
+    }
+    free(contexts);
+    free_assembler_context(&assembler);
+}
+
+/**
+ * @brief Writes the contents of a buffer to a stream.
+ *
+ * @param buffer Pointer to the Buffer to write.
+ * @param stream The stream to write to.
+ */
+static void put_buffer(const Buffer *buffer, FILE *stream) {
+    if (buffer->length > 0) {
+        fwrite(buffer->data, 1, buffer->length, stream);
+    }
+}
+
+/**
+ * @brief Writes the files of a build and prints its messages.
+ *
+ * Old output files are deleted and the .am files written before the output files, and
+ * errors are printed in the order they happened: failures to delete or write .am files,
+ * then the errors of the build, then failures to write the output files. An error of
+ * the first kind fails the assembly, as it always has.
+ *
+ * @param file_count The number of files.
+ * @param filenames The source filenames; their extensions are replaced with ".am".
+ * @param result Pointer to the BuildResult to report.
+ * @param write_preprocessed Whether to write the .am files.
+ * @return True if the assembly succeeded, false otherwise.
+ */
+bool report_build(int file_count, const char **filenames, const BuildResult *result, bool write_preprocessed) {
+    bool success;
+    ErrorList file_errors;
+    ErrorList output_errors;
+
+    if (!result->preprocessed) {
+        put_buffer(&result->diagnostics, stderr);
+        printf("Assembly failed due to errors.\n");
+        return false;
+    }
+
+    init_error_handling(&file_errors);
+    init_error_handling(&output_errors);
+
+    /* Delete previous output files if they exist */
+    delete_output_files(filenames, file_count, &file_errors);
+
+    /* Create preprocessed files from the build */
+    if (write_preprocessed) {
+        write_preprocessed_files(file_count, filenames, result->preprocessed_files, &file_errors);
+    }
+
+    /* Fix the filenames after preprocessing */
+    fix_filenames(filenames, file_count);
+
+    put_buffer(&result->warnings, stderr);
+    success = result->assembled && !has_errors(&file_errors);
+    if (success) {
+        write_output_files(filenames, file_count, &result->output, &output_errors);
+    }
+
+    if (has_errors(&file_errors) || result->diagnostics.length > 0 || has_errors(&output_errors)) {
+        print_errors(&file_errors);
+        put_buffer(&result->diagnostics, stderr);
+        print_errors(&output_errors);
+        printf("Assembly failed due to errors.\n");
+    } else {
+        printf("Assembly completed successfully for all files.\n");
+    }
+
+    free_errors(&file_errors);
+    free_errors(&output_errors);
+    return success;
+}
+
+/**
+ * @brief Appends a number as four big-endian bytes.
+ *
+ * @param encoded Pointer to the Buffer to append to.
+ * @param value The number to append; it must fit in 32 bits.
+ * @return True if the number was appended, false if memory allocation failed.
+ */
+static bool encode_number(Buffer *encoded, unsigned long value) {
+    char bytes[4];
+
+    bytes[0] = (char)((value >> 24) & 0xFF);
+    bytes[1] = (char)((value >> 16) & 0xFF);
+    bytes[2] = (char)((value >> 8) & 0xFF);
+    bytes[3] = (char)(value & 0xFF);
+    return buffer_append(encoded, bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Appends a buffer as its length followed by its bytes.
+ *
+ * @param encoded Pointer to the Buffer to append to.
+ * @param block Pointer to the Buffer to encode.
+ * @return True if the buffer was appended, false otherwise.
+ */
+static bool encode_block(Buffer *encoded, const Buffer *block) {
+    if (block->length > 0xFFFFFFFFUL) {
+        return false;
+    }
+    return encode_number(encoded, (unsigned long) block->length)
+        && buffer_append(encoded, block->data, block->length);
+}
+
+/**
+ * @brief Reads a number appended by encode_number.
+ *
+ * @param data Pointer to the encoded bytes; it is moved past the number.
+ * @param end The end of the encoded bytes.
+ * @param value Pointer to store the number.
+ * @return True if a whole number was read, false otherwise.
+ */
+static bool decode_number(const char **data, const char *end, unsigned long *value) {
+    const unsigned char *bytes = (const unsigned char *)*data;
+
+    if (end - *data < 4) {
+        return false;
+    }
+    *value = ((unsigned long)bytes[0] << 24) | ((unsigned long)bytes[1] << 16)
+           | ((unsigned long)bytes[2] << 8) | (unsigned long)bytes[3];
+    *data += 4;
+    return true;
+}
+
+/**
+ * @brief Reads a buffer appended by encode_block.
+ *
+ * @param data Pointer to the encoded bytes; it is moved past the buffer.
+ * @param end The end of the encoded bytes.
+ * @param block Pointer to the Buffer the bytes are appended to.
+ * @return True if a whole buffer was read, false otherwise.
+ */
+static bool decode_block(const char **data, const char *end, Buffer *block) {
+    unsigned long length;
+
+    if (!decode_number(data, end, &length) || (unsigned long)(end - *data) < length) {
+        return false;
+    }
+    if (!buffer_append(block, *data, (size_t) length)) {
+        return false;
+    }
+    *data += length;
+    return true;
+}
+
+/**
+ * @brief Encodes a build result as bytes that decode_build_result reads back.
+ *
+ * The encoding is whether the files preprocessed and assembled, the .am contents of
+ * each file if they preprocessed, then the warnings, diagnostics, entries, externs and
+ * object contents. Numbers are four big-endian bytes, and each contents is its length
+ * followed by its bytes.
+ *
+ * @param result Pointer to the BuildResult to encode.
+ * @param encoded Pointer to the Buffer the encoding is appended to.
+ * @return True if the result was encoded, false if memory allocation failed.
+ */
+bool encode_build_result(const BuildResult *result, Buffer *encoded) {
+    int i;
+
+    if (!encode_number(encoded, result->preprocessed ? 1 : 0) || !encode_number(encoded, result->assembled ? 1 : 0)) {
+        return false;
+    }
+    if (result->preprocessed) {
+        for (i = 0; i < result->file_count; i++) {
+            if (!encode_block(encoded, &result->preprocessed_files[i])) {
+                return false;
+            }
+        }
+    }
+    return encode_block(encoded, &result->warnings)
+        && encode_block(encoded, &result->diagnostics)
+        && encode_block(encoded, &result->output.entries)
+        && encode_block(encoded, &result->output.externs)
+        && encode_block(encoded, &result->output.object);
+}
+
+/**
+ * @brief Decodes a build result encoded by encode_build_result.
+ *
+ * On failure the result may hold part of the decoded contents; free it with
+ * free_build_result.
+ *
+ * @param data The encoded bytes.
+ * @param length The number of encoded bytes.
+ * @param file_count The number of files the result is expected to hold.
+ * @param result Pointer to the initialized BuildResult to fill.
+ * @return True if the bytes held a result for file_count files, false otherwise.
+ */
+bool decode_build_result(const char *data, size_t length, int file_count, BuildResult *result) {
+    int i;
+    unsigned long preprocessed, assembled;
+    const char *end = data + length;
+
+    if (!decode_number(&data, end, &preprocessed) || !decode_number(&data, end, &assembled)) {
+        return false;
+    }
+    result->file_count = file_count;
+    result->preprocessed = preprocessed != 0;
+    result->assembled = assembled != 0;
+
+    if (result->preprocessed) {
+        result->preprocessed_files = (Buffer *)counted_malloc((file_count > 0 ? file_count : 1) * sizeof(Buffer));
+        if (result->preprocessed_files == NULL) {
+            return false;
+        }
+        for (i = 0; i < file_count; i++) {
+            init_buffer(&result->preprocessed_files[i]);
+        }
+        for (i = 0; i < file_count; i++) {
+            if (!decode_block(&data, end, &result->preprocessed_files[i])) {
+                return false;
+            }
+        }
+    }
+    return decode_block(&data, end, &result->warnings)
+        && decode_block(&data, end, &result->diagnostics)
+        && decode_block(&data, end, &result->output.entries)
+        && decode_block(&data, end, &result->output.externs)
+        && decode_block(&data, end, &result->output.object)
+        && data == end;
+}
+
+/**
+ * @brief Frees everything held by a build result and empties it.
+ *
+ * @param result Pointer to the BuildResult to free.
+ */
+void free_build_result(BuildResult *result) {
+    int i;
+
+    if (result->preprocessed_files != NULL) {
+        for (i = 0; i < result->file_count; i++) {
+            free_buffer(&result->preprocessed_files[i]);
+        }
+        free(result->preprocessed_files);
+    }
+    free_output_files(&result->output);
+    free_buffer(&result->warnings);
+    free_buffer(&result->diagnostics);
+    init_build_result(result);
+}
@@ -0,0 +1,189 @@
+/**
+ * @file cache.c
+ * @brief Implements the on-disk cache of build results, keyed by the contents of the inputs.
+ *
+ * An entry is a file named after the hash of the inputs, holding the inputs followed by
+ * the BuildResult as encoded by encode_build_result.
+ */
+
+#define _POSIX_C_SOURCE 199506L  /* mkdir */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "reader.h"
+#include "stats.h"
+
+#define FNV_PRIME 16777619UL               /* Multiplier of the 32-bit FNV-1a hash */
+#define FNV_OFFSET_BASIS 2166136261UL      /* Starting value of the 32-bit FNV-1a hash */
+#define FNV_SECOND_BASIS 0x9E3779B9UL      /* Starting value of the second hash of a key */
+#define CACHE_ENTRY_SUFFIX ".cache"        /* Extension of the entry files */
+
+/**
+ * @brief Hashes a byte range with 32-bit FNV-1a.
+ *
+ * @param data The bytes to hash.
+ * @param length The number of bytes.
+ * @param hash The value to start from.
+ * @return The 32-bit hash.
+ */
+static unsigned long hash_bytes(const char *data, size_t length, unsigned long hash) {
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        hash ^= (unsigned char) data[i];
+        hash = (hash * FNV_PRIME) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Appends a file to the inputs of a key, as its name and contents lengths, then both.
+ *
+ * @param inputs Pointer to the Buffer of inputs.
+ * @param filename The name of the file.
+ * @param reader Pointer to the LineReader holding the file contents.
+ * @return True if the file was appended, false if memory allocation failed.
+ */
+static bool append_input(Buffer *inputs, const char *filename, const LineReader *reader) {
+    char header[64];
+
+    sprintf(header, "%lu %lu\n", (unsigned long) strlen(filename), (unsigned long) reader->length);
+    return buffer_append_string(inputs, header)
+        && buffer_append_string(inputs, filename)
+        && buffer_append(inputs, reader->data, reader->length);
+}
+
+/**
+ * @brief Builds the path of the entry of a key.
+ *
+ * @param cache_dir The directory of the cache.
+ * @param key Pointer to the CacheKey.
+ * @return The path, which the caller must free, or NULL if memory allocation failed.
+ */
+static char* entry_path(const char *cache_dir, const CacheKey *key) {
+    char *path;
+
+    path = (char *)counted_malloc(strlen(cache_dir) + 1 + CACHE_KEY_LENGTH + sizeof(CACHE_ENTRY_SUFFIX));
+    if (path != NULL) {
+        sprintf(path, "%s/%s%s", cache_dir, key->name, CACHE_ENTRY_SUFFIX);
+    }
+    return path;
+}
+
+/**
+ * @brief Reads the source files of a build into a cache key.
+ *
+ * @param file_count The number of files.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param max_errors The error limit of the build, which changes its messages.
+ * @param key Pointer to the CacheKey to fill; free it with free_cache_key.
+ * @return True if every file was read, false otherwise.
+ */
+bool make_cache_key(int file_count, const char **filenames, int max_errors, CacheKey *key) {
+    int i;
+    bool success;
+    char header[64];
+    LineReader reader;
+
+    init_buffer(&key->inputs);
+    key->name[0] = '\0';
+
+    /* The build ID is appended on its own, since its length is set by the build */
+    sprintf(header, "\n%d %d\n", file_count, max_errors);
+    success = buffer_append_string(&key->inputs, CACHE_VERSION " " ASSEMBLER_BUILD_ID)
+           && buffer_append_string(&key->inputs, header);
+    for (i = 0; success && i < file_count; i++) {
+        success = open_line_reader(&reader, filenames[i]);
+        if (success) {
+            success = append_input(&key->inputs, filenames[i], &reader);
+            close_line_reader(&reader);
+        }
+    }
+
+    if (success) {
+        sprintf(key->name, "%08lx%08lx",
+                hash_bytes(key->inputs.data, key->inputs.length, FNV_OFFSET_BASIS),
+                hash_bytes(key->inputs.data, key->inputs.length, FNV_SECOND_BASIS));
+    }
+    return success;
+}
+
+/**
+ * @brief Looks up the result of a build in the cache.
+ *
+ * @param cache_dir The directory of the cache.
+ * @param key Pointer to the CacheKey of the build.
+ * @param file_count The number of files of the build.
+ * @param result Pointer to the initialized BuildResult to fill.
+ * @return True if the cache held the result, false otherwise; the result is left empty in that case.
+ */
+bool load_cached_build(const char *cache_dir, const CacheKey *key, int file_count, BuildResult *result) {
+    bool found;
+    char *path;
+    LineReader entry;
+
+    path = entry_path(cache_dir, key);
+    if (path == NULL) {
+        return false;
+    }
+    found = open_line_reader(&entry, path);
+    free(path);
+    if (!found) {
+        return false;
+    }
+
+    /* The entry must hold exactly these inputs, so a hash collision is a miss */
+    found = entry.length >= key->inputs.length
+         && memcmp(entry.data, key->inputs.data, key->inputs.length) == 0
+         && decode_build_result(entry.data + key->inputs.length, entry.length - key->inputs.length, file_count, result);
+    if (!found) {
+        free_build_result(result);
+    }
+    close_line_reader(&entry);
+    return found;
+}
+
+/**
+ * @brief Stores the result of a build in the cache, creating the cache directory if needed.
+ *
+ * A result that cannot be stored is silently left out of the cache.
+ *
+ * @param cache_dir The directory of the cache.
+ * @param key Pointer to the CacheKey of the build.
+ * @param result Pointer to the BuildResult to store.
+ */
+void store_cached_build(const char *cache_dir, const CacheKey *key, const BuildResult *result) {
+    char *path;
+    Buffer entry;
+
+    if (result->file_count == 0) {
+        return;  /* The build did not run */
+    }
+
+    path = entry_path(cache_dir, key);
+    if (path == NULL) {
+        return;
+    }
+    mkdir(cache_dir, 0777);  /* Fails harmlessly if the directory exists */
+
+    init_buffer(&entry);
+    if (buffer_append(&entry, key->inputs.data, key->inputs.length) && encode_build_result(result, &entry)) {
+        write_buffer_to_file(&entry, path);
+    }
+    free_buffer(&entry);
+    free(path);
+}
+
+/**
+ * @brief Frees the inputs held by a cache key.
+ *
+ * @param key Pointer to the CacheKey to free.
+ */
+void free_cache_key(CacheKey *key) {
+    free_buffer(&key->inputs);
+    key->name[0] = '\0';
+}
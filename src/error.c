@@ -3,28 +3,24 @@
  * @brief Manages error reporting throughout the assembly process.
  *
  * This file provides functions for error handling, including initialization, error logging,
- * and printing errors. It maintains a centralized error reporting mechanism to ensure consistent
- * error messages across the program.
+ * and printing errors. Errors are collected in an ErrorList owned by the caller, so every
+ * assembly keeps its own errors while sharing the same error messages.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "error.h"
+#include "stats.h"
+#include "buffer.h"
 
 #define INITIAL_ERROR_CAPACITY 10
-
-/** Array to hold the errors encountered during execution. */
-static Error *errors = NULL;
-/** The current number of errors recorded. */
-static int error_count = 0;
-/** The current capacity of the errors array. */
-static int error_capacity = 0;
-/** A flag indicating whether any errors have occurred. */
-static bool error_flag = false;
+#define ERROR_PREFIX "Error in file "     /* Start of every message, followed by the file name */
+#define ERROR_LINE_FORMAT " at line %d: "  /* Follows the file name, before the message */
+#define DETAIL_MARK "%s"                   /* Where the detail goes in a message */
 
 /** Array of error messages corresponding to error codes. */
-const char *error_messages[] = {
+static const char *error_messages[] = {
         "File not found: %s",
         "Macro name missing.",
         "Macro name is not valid: %s",
@@ -48,89 +44,263 @@ const char *error_messages[] = {
 };
 
 /**
- * @brief Initializes the error handling system.
+ * @brief Interns a file name or detail in an error list.
+ *
+ * @param list Pointer to the ErrorList.
+ * @param text The text to intern.
+ * @return The symbol ID of the text.
+ */
+static int intern_error_text(ErrorList *list, const char *text) {
+    int symbol = intern_symbol(&list->strings, text);
+    if (symbol == NO_SYMBOL) {
+        fprintf(stderr, "Failed to allocate memory for error handling.\n");
+        exit(EXIT_FAILURE);
+    }
+    return symbol;
+}
+
+/**
+ * @brief Makes sure an error list has room for more errors.
  *
- * Allocates memory for storing errors and sets up the initial error handling state.
+ * @param list Pointer to the ErrorList.
+ * @param count The number of errors to make room for.
  */
-void init_error_handling() {
-    if (errors != NULL) {
-        free(errors);
+static void reserve_errors(ErrorList *list, int count) {
+    int capacity = list->capacity;
+
+    if (list->count + count <= capacity) {
+        return;
     }
-    error_count = 0;
-    error_capacity = INITIAL_ERROR_CAPACITY;
-    errors = (Error *)malloc(error_capacity * sizeof(Error));
-    if (errors == NULL) {
+    while (list->count + count > capacity) {
+        capacity = (capacity == 0) ? INITIAL_ERROR_CAPACITY : capacity * 2;
+    }
+    list->errors = (Error *)counted_realloc(list->errors, capacity * sizeof(Error));
+    if (list->errors == NULL) {
+        fprintf(stderr, "Failed to reallocate memory for error handling.\n");
+        exit(EXIT_FAILURE);
+    }
+    list->capacity = capacity;
+}
+
+/**
+ * @brief Formats one error into a buffer, as a line of the form print_errors prints.
+ *
+ * @param list Pointer to the ErrorList holding the error.
+ * @param error Pointer to the Error to format.
+ * @param buffer Pointer to the Buffer to append the line to.
+ * @return true if the line was appended, false if memory allocation failed.
+ */
+static bool format_error(const ErrorList *list, const Error *error, Buffer *buffer) {
+    const char *message = error_messages[error->code];
+    const char *mark = (error->detail == NO_SYMBOL) ? NULL : strstr(message, DETAIL_MARK);
+    char line[64];
+
+    sprintf(line, ERROR_LINE_FORMAT, error->line);
+    if (!buffer_append_string(buffer, ERROR_PREFIX)
+            || !buffer_append_string(buffer, symbol_name(&list->strings, error->file))
+            || !buffer_append_string(buffer, line)) {
+        return false;
+    }
+    if (mark == NULL) {
+        return buffer_append_string(buffer, message) && buffer_append_string(buffer, "\n");
+    }
+    return buffer_append(buffer, message, (size_t)(mark - message))
+        && buffer_append_string(buffer, symbol_name(&list->strings, error->detail))
+        && buffer_append_string(buffer, mark + strlen(DETAIL_MARK))
+        && buffer_append_string(buffer, "\n");
+}
+
+/**
+ * @brief Formats the note that ends the messages of a list that reached its limit.
+ *
+ * @param list Pointer to the ErrorList.
+ * @param buffer Pointer to the Buffer to append the note to.
+ * @return true if the note was appended or not needed, false if memory allocation failed.
+ */
+static bool format_limit_note(const ErrorList *list, Buffer *buffer) {
+    char note[96];
+
+    if (!error_limit_reached(list)) {
+        return true;
+    }
+    sprintf(note, "Stopped after %d errors; further errors were not reported.\n", list->limit);
+    return buffer_append_string(buffer, note);
+}
+
+/**
+ * @brief Initializes an error list.
+ *
+ * Allocates memory for storing errors and sets up an empty list with no limit.
+ *
+ * @param list Pointer to the ErrorList to initialize.
+ */
+void init_error_handling(ErrorList *list) {
+    list->count = 0;
+    list->limit = 0;
+    init_arena(&list->arena);
+    init_symbol_table(&list->strings, &list->arena);
+    list->capacity = INITIAL_ERROR_CAPACITY;
+    list->errors = (Error *)counted_malloc(list->capacity * sizeof(Error));
+    if (list->errors == NULL) {
         fprintf(stderr, "Failed to allocate memory for error handling.\n");
         exit(EXIT_FAILURE);
     }
-    error_flag = false;
 }
 
 /**
- * @brief Adds an error to the error log.
+ * @brief Adds an error to an error list, unless the list has reached its limit.
+ *
+ * Only the code, the line and the IDs of the interned file name and detail are
+ * stored; the message is formatted when it is printed.
  *
+ * @param list Pointer to the ErrorList to add to.
  * @param code The error code representing the type of error.
  * @param filename The name of the file where the error occurred.
  * @param line The line number where the error occurred.
- * @param detail Additional details about the error.
+ * @param detail Additional details about the error, or NULL.
  */
-void add_error(ErrorCode code, const char *filename, int line, const char *detail) {
-    if (error_count >= error_capacity) {
-        error_capacity *= 2;
-        errors = (Error *)realloc(errors, error_capacity * sizeof(Error));
-        if (errors == NULL) {
-            fprintf(stderr, "Failed to reallocate memory for error handling.\n");
-            exit(EXIT_FAILURE);
-        }
+void add_error(ErrorList *list, ErrorCode code, const char *filename, int line, const char *detail) {
+    Error *error;
+
+    if (error_limit_reached(list)) {
+        return;
     }
+    reserve_errors(list, 1);
 
-    errors[error_count].code = code;
-    strncpy(errors[error_count].filename, filename, sizeof(errors[error_count].filename) - 1);
-    errors[error_count].filename[sizeof(errors[error_count].filename) - 1] = '\0';
-    errors[error_count].line = line;
+    error = &list->errors[list->count];
+    error->code = code;
+    error->file = intern_error_text(list, filename);
+    error->line = line;
+    error->detail = (detail != NULL) ? intern_error_text(list, detail) : NO_SYMBOL;
+    list->count++;
+}
+
+/**
+ * @brief Appends copies of a range of the errors of one list to the end of another.
+ *
+ * The file names and details are interned again in the list appended to. Errors past
+ * the limit of the list are dropped.
+ *
+ * @param list Pointer to the ErrorList to append to.
+ * @param other Pointer to the ErrorList whose errors are copied.
+ * @param first The index of the first error to copy.
+ * @param count The number of errors to copy.
+ */
+void append_error_range(ErrorList *list, const ErrorList *other, int first, int count) {
+    const Error *source;
+    Error *error;
+    int i;
+
+    if (count <= 0) {
+        return;
+    }
+    if (list->limit > 0 && count > list->limit - list->count) {
+        count = list->limit - list->count;
+    }
+    reserve_errors(list, count);
 
-    if (detail) {
-        sprintf(errors[error_count].message, error_messages[code], detail);
-    } else {
-        strncpy(errors[error_count].message, error_messages[code], sizeof(errors[error_count].message) - 1);
-        errors[error_count].message[sizeof(errors[error_count].message) - 1] = '\0';
+    for (i = 0; i < count; i++) {
+        source = &other->errors[first + i];
+        error = &list->errors[list->count];
+        error->code = source->code;
+        error->file = intern_error_text(list, symbol_name(&other->strings, source->file));
+        error->line = source->line;
+        error->detail = (source->detail != NO_SYMBOL) ? intern_error_text(list, symbol_name(&other->strings, source->detail)) : NO_SYMBOL;
+        list->count++;
     }
-    error_count++;
-    error_flag = true;
+}
+
+/**
+ * @brief Appends copies of every error of one list to the end of another.
+ *
+ * This is how errors collected separately for each file are combined in file order.
+ *
+ * @param list Pointer to the ErrorList to append to.
+ * @param other Pointer to the ErrorList whose errors are copied.
+ */
+void append_errors(ErrorList *list, const ErrorList *other) {
+    append_error_range(list, other, 0, other->count);
+}
+
+/**
+ * @brief Checks if a list has as many errors as its limit allows.
+ *
+ * Parsing stops once this holds, since the errors it would find are dropped.
+ *
+ * @param list Pointer to the ErrorList to check.
+ * @return true if the list has a limit and has reached it, false otherwise.
+ */
+bool error_limit_reached(const ErrorList *list) {
+    return list->limit > 0 && list->count >= list->limit;
 }
 
 /**
  * @brief Prints all recorded errors to stderr.
  *
- * This function iterates through the recorded errors and prints each one
- * to the standard error stream.
+ * This function iterates through the recorded errors, formatting and printing each
+ * one to the standard error stream.
+ *
+ * @param list Pointer to the ErrorList to print.
+ */
+void print_errors(const ErrorList *list) {
+    int i;
+    Buffer line;
+
+    init_buffer(&line);
+    for (i = 0; i < list->count; i++) {
+        line.length = 0;
+        if (format_error(list, &list->errors[i], &line)) {
+            fwrite(line.data, 1, line.length, stderr);
+        }
+    }
+    line.length = 0;
+    if (format_limit_note(list, &line) && line.length > 0) {
+        fwrite(line.data, 1, line.length, stderr);
+    }
+    free_buffer(&line);
+}
+
+/**
+ * @brief Formats all recorded errors into a buffer, as print_errors would print them.
+ *
+ * @param list Pointer to the ErrorList to format.
+ * @param buffer Pointer to the Buffer to append the messages to.
+ * @return true if every message was appended, false if memory allocation failed.
  */
-void print_errors() {
+bool format_errors(const ErrorList *list, Buffer *buffer) {
     int i;
-    for (i = 0; i < error_count; i++) {
-        fprintf(stderr, "Error in file %s at line %d: %s\n", errors[i].filename, errors[i].line, errors[i].message);
+
+    for (i = 0; i < list->count; i++) {
+        if (!format_error(list, &list->errors[i], buffer)) {
+            return false;
+        }
     }
+    return format_limit_note(list, buffer);
 }
 
 /**
  * @brief Checks if any errors have been recorded.
  *
+ * @param list Pointer to the ErrorList to check.
  * @return true if errors have been recorded, false otherwise.
  */
-bool has_errors() {
-    return error_flag;
+bool has_errors(const ErrorList *list) {
+    return list->count > 0;
 }
 
 /**
- * @brief Frees the memory allocated for error handling.
+ * @brief Frees the memory used by an error list.
  *
  * This function cleans up the memory used to store errors and resets
- * the error handling state.
+ * the list to empty.
+ *
+ * @param list Pointer to the ErrorList to free.
  */
-void free_errors() {
-    free(errors);
-    errors = NULL;
-    error_count = 0;
-    error_capacity = 0;
-    error_flag = false;
+void free_errors(ErrorList *list) {
+    free(list->errors);
+    list->errors = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    free_symbol_table(&list->strings);
+    free_arena(&list->arena);
 }
@@ -10,6 +10,7 @@
 #include <ctype.h>
 #include "file_manager.h"
 #include "error.h"
+#include "stats.h"
 
 #define MAX_FILENAME_LENGTH 256
 
@@ -20,16 +21,17 @@
  *
  * @param filenames The list of source filenames.
  * @param file_count The number of files in the list.
+ * @param errors The error list that failed deletions are reported to.
  */
-void delete_output_files(const char **filenames, int file_count) {
+void delete_output_files(const char **filenames, int file_count, ErrorList *errors) {
     int i;
     char *formatted_filename = extract_and_format_filename(filenames, file_count);
 
     for (i = 0; i < file_count; i++) {
-        delete_file(formatted_filename, ".ent");
-        delete_file(formatted_filename, ".ext");
-        delete_file(formatted_filename, ".ob");
-        delete_file(filenames[i], ".am");
+        delete_file(formatted_filename, ".ent", errors);
+        delete_file(formatted_filename, ".ext", errors);
+        delete_file(formatted_filename, ".ob", errors);
+        delete_file(filenames[i], ".am", errors);
     }
 
     free(formatted_filename);
@@ -40,8 +42,9 @@ void delete_output_files(const char **filenames, int file_count) {
  *
  * @param filename The base filename.
  * @param extension The file extension to delete.
+ * @param errors The error list that a failed deletion is reported to.
  */
-void delete_file(const char *filename, const char *extension) {
+void delete_file(const char *filename, const char *extension, ErrorList *errors) {
     char filepath[MAX_FILENAME_LENGTH + 3];  /* Original length + "./" + null terminator */
     FILE *file;
     int deleted;
@@ -53,7 +56,7 @@ void delete_file(const char *filename, const char *extension) {
         fclose(file);
         deleted = remove(filepath);
         if (deleted != 0) {
-            add_error(ERR_FILE_NOT_FOUND, filepath, 0, NULL);
+            add_error(errors, ERR_FILE_NOT_FOUND, filepath, 0, NULL);
         }
     }
 }
@@ -88,7 +91,7 @@ char* extract_and_format_filename(const char **filenames, int file_count) {
         total_length += 1; /* For underscores between filenames */
     }
 
-    final_filename = (char *)malloc(total_length + 1);
+    final_filename = (char *)counted_malloc(total_length + 1);
     if (!final_filename) {
         perror("Memory allocation error");
         return NULL;
@@ -124,129 +127,168 @@ char* extract_and_format_filename(const char **filenames, int file_count) {
 }
 
 /**
- * @brief Writes output files (.ent, .ext, .ob) based on the memory content.
+ * @brief Writes a formatted output buffer to "./<filename><extension>".
  *
- * This function creates the output files required by the assembler, such as the entry file (.ent),
- * the external file (.ext), and the object file (.ob). It also prints the paths of the created files.
+ * @param buffer The buffer holding the complete file contents.
+ * @param filename The base filename for the output file.
+ * @param extension The file extension, including the leading dot.
+ * @param errors The error list that a failed write is reported to.
+ */
+static void flush_output_file(const Buffer *buffer, const char *filename, const char *extension, ErrorList *errors) {
+    char *filepath = (char *)counted_malloc(strlen(filename) + strlen(extension) + 3);  /* "./" + null terminator */
+    if (filepath == NULL) {
+        add_error(errors, ERR_MEMORY_ALLOCATION_FAILED, filename, 0, NULL);
+        return;
+    }
+
+    sprintf(filepath, "./%s%s", filename, extension);
+    if (!write_buffer_to_file(buffer, filepath)) {
+        add_error(errors, ERR_FILE_NOT_FOUND, filepath, 0, NULL);
+    }
+    free(filepath);
+}
+
+/**
+ * @brief Initializes empty output file contents.
  *
- * @param filenames The list of source filenames.
- * @param file_count The number of source files.
- * @param mem Pointer to the Memory structure.
+ * @param output Pointer to the OutputFiles to initialize.
  */
-void write_output_files(const char **filenames, int file_count, Memory *mem) {
-    Label *label;
-    ListNode *node;
-    bool has_entry = false;
-    bool has_extern = false;
-    char *formatted_filename = extract_and_format_filename(filenames, file_count);
+void init_output_files(OutputFiles *output) {
+    init_buffer(&output->entries);
+    init_buffer(&output->externs);
+    init_buffer(&output->object);
+}
 
-    printf("Created output files:\n");
+/**
+ * @brief Formats the contents of the output files (.ent, .ext, .ob) from the assembler's memory content.
+ *
+ * @param mem A pointer to the Memory structure containing the assembler's state.
+ * @param output Pointer to the OutputFiles that receive the contents.
+ * @return True if the contents were formatted, false if memory allocation failed.
+ */
+bool format_output_files(const Memory *mem, OutputFiles *output) {
+    Label *label;
+    int i;
+    char header[32];
+    bool formatted = true;
 
-    for (label = mem->label_list; label != NULL; label = label->next) {
+    begin_stage(STAGE_OUTPUT);
+    for (label = mem->labels.head; label != NULL && formatted; label = label->next) {
         if (label->entry) {
-            write_to_entry_file(label->name, label->address, formatted_filename);
-            has_entry = true;
+            formatted = write_to_entry_file(&output->entries, label->name, label->address);
         } else if (label->external) {
-            write_to_extern_file(label->name, label->address, formatted_filename);
-            has_extern = true;
+            formatted = write_to_extern_file(&output->externs, label->name, label->address);
         }
     }
 
-    for (node = mem->instructionList; node != NULL; node = node->next) {
-        write_to_object_file(node->address, node->data, formatted_filename, mem);
+    if (formatted && (mem->instructions.count > 0 || mem->data.count > 0)) {
+        sprintf(header, "   %d %d\n", mem->IC, mem->DC - INITIAL_DC);
+        formatted = buffer_append_string(&output->object, header);
     }
 
-    for (node = mem->dataList; node != NULL; node = node->next) {
-        write_to_object_file(node->address, node->data, formatted_filename, mem);
+    /* Word addresses follow from their indexes, relocated past the load address and the instructions */
+    for (i = 0; i < mem->instructions.count && formatted; i++) {
+        formatted = write_to_object_file(&output->object, instruction_address(i), mem->instructions.words[i]);
     }
 
-    if (has_entry) {
+    for (i = 0; i < mem->data.count && formatted; i++) {
+        formatted = write_to_object_file(&output->object, data_address(mem, i), mem->data.words[i]);
+    }
+    end_stage(STAGE_OUTPUT);
+    return formatted;
+}
+
+/**
+ * @brief Writes output files (.ent, .ext, .ob) from their formatted contents.
+ *
+ * This function creates the output files required by the assembler, such as the entry file (.ent),
+ * the external file (.ext), and the object file (.ob). Each file is written with a single write.
+ * It also prints the paths of the created files.
+ *
+ * @param filenames The list of source filenames.
+ * @param file_count The number of source files.
+ * @param output Pointer to the formatted OutputFiles.
+ * @param errors The error list that failed writes are reported to.
+ */
+void write_output_files(const char **filenames, int file_count, const OutputFiles *output, ErrorList *errors) {
+    char *formatted_filename = extract_and_format_filename(filenames, file_count);
+
+    begin_stage(STAGE_OUTPUT);
+    printf("Created output files:\n");
+
+    if (output->entries.length > 0) {
+        flush_output_file(&output->entries, formatted_filename, ".ent", errors);
         printf("  Entry file: ./%s.ent\n", formatted_filename);
     }
 
-    if (has_extern) {
+    if (output->externs.length > 0) {
+        flush_output_file(&output->externs, formatted_filename, ".ext", errors);
         printf("  External file: ./%s.ext\n", formatted_filename);
     }
 
+    if (output->object.length > 0) {
+        flush_output_file(&output->object, formatted_filename, ".ob", errors);
+    }
     printf("  Object file: ./%s.ob\n", formatted_filename);
 
     free(formatted_filename);
+    end_stage(STAGE_OUTPUT);
+}
+
+/**
+ * @brief Frees the contents of the output files.
+ *
+ * @param output Pointer to the OutputFiles to free.
+ */
+void free_output_files(OutputFiles *output) {
+    free_buffer(&output->entries);
+    free_buffer(&output->externs);
+    free_buffer(&output->object);
 }
 
 /**
- * @brief Writes to the entry (.ent) file for a given label.
+ * @brief Formats an entry (.ent) file line for a given label.
  *
+ * @param entries The buffer holding the entry file contents.
  * @param name The label name.
  * @param address The address of the label.
- * @param filename The base filename for the output file.
+ * @return True if the line was appended, false if memory allocation failed.
  */
-void write_to_entry_file(char *name, int address, char *filename) {
-    char filepath[MAX_FILENAME_LENGTH + 7];  /* "./" + filename + ".ent" + null terminator */
-    FILE *file;
+bool write_to_entry_file(Buffer *entries, const char *name, int address) {
+    char line[16];
 
-    sprintf(filepath, "./%s.ent", filename);
-
-    file = fopen(filepath, "a");
-    if (file){
-        fprintf(file, "%s %03d\n", name, address);
-        fclose(file);
-    } else {
-        add_error(ERR_FILE_NOT_FOUND, filepath, 0, NULL);
-    }
+    sprintf(line, " %03d\n", address);
+    return buffer_append_string(entries, name) && buffer_append_string(entries, line);
 }
 
 /**
- * @brief Writes to the extern (.ext) file for a given label.
+ * @brief Formats an extern (.ext) file line for a given label.
  *
+ * @param externs The buffer holding the extern file contents.
  * @param name The label name.
  * @param address The address of the label.
- * @param filename The base filename for the output file.
+ * @return True if the line was appended, false if memory allocation failed.
  */
-void write_to_extern_file(char *name, int address, char *filename) {
-    char filepath[MAX_FILENAME_LENGTH + 7];  /* "./" + filename + ".ext" + null terminator */
-    FILE *file;
+bool write_to_extern_file(Buffer *externs, const char *name, int address) {
+    char line[16];
 
-    sprintf(filepath, "./%s.ext", filename);
-
-    file = fopen(filepath, "a");
-    if (file){
-        fprintf(file, "%s %04d\n", name, address);
-        fclose(file);
-    } else {
-        add_error(ERR_FILE_NOT_FOUND, filepath, 0, NULL);
-    }
+    sprintf(line, " %04d\n", address);
+    return buffer_append_string(externs, name) && buffer_append_string(externs, line);
 }
 
 /**
- * @brief Writes to the object (.ob) file.
+ * @brief Formats an object (.ob) file line for a single word.
  *
+ * @param object The buffer holding the object file contents.
  * @param address The memory address of the data.
  * @param data The data to write to the file.
- * @param filename The base filename for the output file.
- * @param mem Pointer to the Memory structure.
+ * @return True if the line was appended, false if memory allocation failed.
  */
-void write_to_object_file(int address, int data, char *filename, Memory *mem) {
-    char filepath[MAX_FILENAME_LENGTH + 7];  /* "./" + filename + ".ob" + null terminator */
-    FILE *file;
+bool write_to_object_file(Buffer *object, int address, int data) {
+    char line[32];
 
-    sprintf(filepath, "./%s.ob", filename);
-
-    file = fopen(filepath, "r");
-    if (file == NULL) {
-        file = fopen(filepath, "a");
-        if (file) {
-            fprintf(file, "   %d %d\n", mem->IC, mem->DC - 100);
-            fprintf(file, "%04d %05o\n", address, data);
-            fclose(file);
-        }
-    } else {
-        fclose(file);
-        file = fopen(filepath, "a");
-        if (file) {
-            fprintf(file, "%04d %05o\n", address, data);
-            fclose(file);
-        }
-    }
+    sprintf(line, "%04d %05o\n", address, data);
+    return buffer_append_string(object, line);
 }
 
 /**
@@ -263,26 +305,27 @@ void add_as_suffix(char *filename) {
 /**
  * @brief Prepares the filenames for processing by appending the ".as" suffix if necessary.
  *
- * @param argc The number of command-line arguments.
- * @param argv The list of command-line arguments.
+ * @param argc The number of source file arguments.
+ * @param argv The list of source file arguments.
  * @param filenames_ptr Pointer to the list of filenames to be populated.
  * @param file_count Pointer to the count of filenames to be populated.
+ * @param errors The error list that a missing file is reported to.
  * @return True if the filenames were prepared successfully, false otherwise.
  */
-bool prepare_filenames(int argc, char *argv[], const char ***filenames_ptr, int *file_count) {
+bool prepare_filenames(int argc, char *argv[], const char ***filenames_ptr, int *file_count, ErrorList *errors) {
     int i, j;
     char *filename_with_suffix;
     FILE *file;
 
-    *file_count = argc - 1;
-    *filenames_ptr = (const char **) malloc(*file_count * sizeof(char *));
+    *file_count = argc;
+    *filenames_ptr = (const char **) counted_malloc(*file_count * sizeof(char *));
     if (*filenames_ptr == NULL) {
         fprintf(stderr, "Failed to allocate memory for filenames.\n");
         return false;
     }
 
-    for (i = 1; i < argc; i++) {
-        filename_with_suffix = (char *) malloc(MAX_FILENAME_LENGTH * sizeof(char));
+    for (i = 0; i < argc; i++) {
+        filename_with_suffix = (char *) counted_malloc(MAX_FILENAME_LENGTH * sizeof(char));
         if (filename_with_suffix == NULL) {
             fprintf(stderr, "Failed to allocate memory for filename.\n");
             for (j = 0; j < i; j++) {
@@ -297,16 +340,16 @@ bool prepare_filenames(int argc, char *argv[], const char ***filenames_ptr, int
 
         file = fopen(filename_with_suffix, "r");
         if (!file) {
-            add_error(ERR_FILE_NOT_FOUND, filename_with_suffix, 0, NULL);
+            add_error(errors, ERR_FILE_NOT_FOUND, filename_with_suffix, 0, NULL);
             free(filename_with_suffix);
-            for (j = 0; j < i - 1; j++) {
+            for (j = 0; j < i; j++) {
                 free((void *) (*filenames_ptr)[j]);
             }
             free(*filenames_ptr);
             return false;
         }
         fclose(file);
-        (*filenames_ptr)[i - 1] = filename_with_suffix;
+        (*filenames_ptr)[i] = filename_with_suffix;
     }
 
     return true;
@@ -348,41 +391,55 @@ void fix_filenames(const char **filenames, int count) {
 }
 
 /**
- * @brief Creates preprocessed output files (.am) from the given contexts.
+ * @brief Formats the preprocessed lines of a context as the contents of its .am file.
  *
- * @param file_count The number of files.
- * @param contexts The list of contexts containing preprocessed lines.
+ * @param context Pointer to the Context holding the preprocessed lines.
+ * @param contents Pointer to the Buffer that receives the contents.
+ * @return True if the contents were formatted, false if memory allocation failed.
  */
-void create_preprocessed_files(int file_count, Context *contexts) {
-    int i, j;
+bool format_preprocessed_file(const Context *context, Buffer *contents) {
+    int i;
+
+    for (i = 0; i < context->line_count; i++) {
+        if (!buffer_append_string(contents, context->preprocessed_lines[i]) || !buffer_append(contents, "\n", 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the preprocessed (.am) file of each source from its formatted contents.
+ *
+ * The .am name replaces a trailing ".as" of the source name, or is appended to it.
+ *
+ * @param file_count The number of files to write.
+ * @param filenames The source filenames the .am names are derived from.
+ * @param contents The .am contents of each file.
+ * @param errors The error list that failed writes are reported to.
+ */
+void write_preprocessed_files(int file_count, const char **filenames, const Buffer *contents, ErrorList *errors) {
+    int i;
     char output_filename[MAX_FILENAME_LENGTH];
-    FILE *output;
 
+    begin_stage(STAGE_OUTPUT);
     for (i = 0; i < file_count; i++) {
-        size_t len = strlen(contexts[i].filename);
-        if (len > 3 && strcmp(contexts[i].filename + len - 3, ".as") == 0) {
-            strncpy(output_filename, contexts[i].filename, len - 3);
+        size_t len = strlen(filenames[i]);
+        if (len > 3 && strcmp(filenames[i] + len - 3, ".as") == 0) {
+            strncpy(output_filename, filenames[i], len - 3);
             output_filename[len - 3] = '\0';
             strcat(output_filename, ".am");
         } else {
-            strncpy(output_filename, contexts[i].filename, len);
+            strncpy(output_filename, filenames[i], len);
             output_filename[len] = '\0';
             strcat(output_filename, ".am");
         }
 
-        output = fopen(output_filename, "w");
-        if (!output) {
-            add_error(ERR_FILE_NOT_FOUND, output_filename, 0, NULL);
+        if (!write_buffer_to_file(&contents[i], output_filename)) {
+            add_error(errors, ERR_FILE_NOT_FOUND, output_filename, 0, NULL);
             continue;
         }
-
-        for (j = 0; j < contexts[i].line_count; j++) {
-            fputs(contexts[i].preprocessed_lines[j], output);
-            fputs("\n", output);
-            free(contexts[i].preprocessed_lines[j]);
-            contexts[i].preprocessed_lines[j] = NULL;
-        }
-        fclose(output);
         printf("Preprocessing succeeded. Output written to %s\n", output_filename);
     }
+    end_stage(STAGE_OUTPUT);
 }
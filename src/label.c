@@ -8,51 +8,73 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 #include "label.h"
 #include "utils.h"
+#include "stats.h"
+
+#define INITIAL_LABEL_CAPACITY 64
 
 /**
- * @brief Creates a new label with the provided details.
+ * @brief Grows the slot array of the table until it has a slot for the given symbol ID.
  *
- * @param name The name of the label.
+ * @param table The label table to grow.
+ * @param symbol The symbol ID that needs a slot.
+ * @return True if the table has a slot for the symbol, otherwise false.
+ */
+static bool grow_table(LabelTable *table, int symbol) {
+    int capacity = (table->capacity == 0) ? INITIAL_LABEL_CAPACITY : table->capacity;
+    Label **slots;
+    int i;
+
+    while (capacity <= symbol) {
+        capacity *= 2;
+    }
+    slots = (Label **)counted_realloc(table->slots, capacity * sizeof(Label *));
+    if (slots == NULL) {
+        fprintf(stderr, "Memory allocation error for label table\n");
+        return false;
+    }
+    for (i = table->capacity; i < capacity; i++) {
+        slots[i] = NULL;
+    }
+
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Creates a new label with the provided details in the given arena.
+ *
+ * @param arena The arena to allocate the label from.
+ * @param name The interned name of the label; it is referenced, not copied.
+ * @param symbol The symbol ID of the name.
  * @param address The address associated with the label.
  * @param is_instruction Whether the label is associated with an instruction.
  * @param entry Whether the label is marked as an entry.
  * @param external Whether the label is marked as external.
- * @param file_name The name of the file where the label is declared.
+ * @param file_name The name of the file where the label is declared; it is referenced, not copied.
  * @param declared Whether the label has been declared.
  * @param line_number The line number where the label is declared.
  * @return A pointer to the newly created label, or NULL if memory allocation fails.
  */
-Label* create_label(char *name, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number) {
-    Label *new_label = (Label *)malloc(sizeof(Label));
+Label* create_label(Arena *arena, char *name, int symbol, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number) {
+    Label *new_label = (Label *)arena_alloc(arena, sizeof(Label));
     if (new_label == NULL) {
         fprintf(stderr, "Memory allocation error for label\n");
         return NULL;
     }
 
-    new_label->name = str_duplicate(name);
-    if (new_label->name == NULL) {
-        fprintf(stderr, "Memory allocation error for label name\n");
-        free(new_label);  /* Free the already allocated memory for the label */
-        return NULL;
-    }
-
-    new_label->file_name = str_duplicate(file_name);
-    if (new_label->file_name == NULL) {
-        fprintf(stderr, "Memory allocation error for label file_name\n");
-        free(new_label->name);  /* Free the already allocated memory for the label name */
-        free(new_label);         /* Free the already allocated memory for the label itself */
-        return NULL;
-    }
-
+    new_label->name = name;
+    new_label->file_name = file_name;
     new_label->address = address;
     new_label->is_instruction = is_instruction;
     new_label->entry = entry;
     new_label->external = external;
     new_label->declared = declared;
     new_label->line_number = line_number;
+    new_label->symbol = symbol;
+    new_label->fixup_chain = -1;
     new_label->next = NULL;
 
     return new_label;
@@ -60,105 +82,111 @@ Label* create_label(char *name, int address, bool is_instruction, bool entry, bo
 
 
 /**
- * @brief Adds a label to the label list.
+ * @brief Initializes an empty label table.
  *
- * @param label_list Pointer to the head of the label list.
- * @param name The name of the label.
+ * @param table Pointer to the LabelTable to initialize.
+ * @param arena The arena that labels added to the table are allocated from.
+ * @param symbols The symbol table that label names are interned in.
+ */
+void init_label_table(LabelTable *table, Arena *arena, SymbolTable *symbols) {
+    table->arena = arena;
+    table->symbols = symbols;
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+    table->head = NULL;
+    table->tail = NULL;
+}
+
+/**
+ * @brief Adds a label to the label table, or updates it if a label with the same name exists.
+ *
+ * @param table Pointer to the label table.
+ * @param symbol The symbol ID of the label name, interned in the table's symbol table.
  * @param address The address associated with the label.
  * @param is_instruction Whether the label is associated with an instruction.
  * @param entry Whether the label is marked as an entry.
  * @param external Whether the label is marked as external.
- * @param file_name The name of the file where the label is declared.
+ * @param file_name The name of the file where the label is declared; it is referenced, not copied.
  * @param declared Whether the label has been declared.
  * @param line_number The line number where the label is declared.
- * @return True if the label was added successfully, otherwise false.
+ * @return A pointer to the added or updated label, or NULL if memory allocation fails.
  */
-bool add_label(Label **label_list, char *name, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number) {
-    /* Check if the label already exists */
+Label* add_label(LabelTable *table, int symbol, int address, bool is_instruction, bool entry, bool external, char *file_name, bool declared, int line_number) {
     Label *new_label;
-    Label *existing_label = find_label(*label_list, name);
-    if (existing_label != NULL) {
-        /* Free the existing label's memory before replacing it */
-        free(existing_label->name);
-        free(existing_label->file_name);
-        existing_label->name = str_duplicate(name);
-        existing_label->file_name = str_duplicate(file_name);
+
+    if (symbol >= table->capacity && !grow_table(table, symbol)) {
+        return NULL;
+    }
+
+    /* Check if the label already exists; callers have counted the lookup */
+    if (table->slots[symbol] != NULL) {
+        Label *existing_label = table->slots[symbol];
+        existing_label->file_name = file_name;
         existing_label->address = address;
         existing_label->is_instruction = is_instruction;
         existing_label->entry = entry;
         existing_label->external = external;
         existing_label->declared = declared;
         existing_label->line_number = line_number;
-        return true;
+        return existing_label;
     }
 
     /* Otherwise, add the new label */
-    new_label = create_label(name, address, is_instruction, entry, external, file_name, declared, line_number);
+    new_label = create_label(table->arena, symbol_name(table->symbols, symbol), symbol, address, is_instruction, entry, external, file_name, declared, line_number);
     if (new_label == NULL) {
-        return false;
+        return NULL;
     }
 
-    if (*label_list == NULL) {
-        *label_list = new_label;
+    table->slots[symbol] = new_label;
+    table->count++;
+    if (table->tail == NULL) {
+        table->head = new_label;
     } else {
-        Label *current = *label_list;
-        while (current->next != NULL) {
-            current = current->next;
-        }
-        current->next = new_label;
+        table->tail->next = new_label;
     }
+    table->tail = new_label;
 
-    return true;
+    return new_label;
 }
 
 
 /**
- * @brief Finds a label by its name in the label list.
+ * @brief Finds a label by its name in the label table.
  *
- * @param label_list The list of labels.
+ * @param table The label table.
  * @param name The name of the label to find.
  * @return A pointer to the found label, or NULL if the label is not found.
  */
-Label* find_label(Label *label_list, char *name) {
-    while (label_list != NULL) {
-        if (strcmp(label_list->name, name) == 0) {
-            return label_list;
-        }
-        label_list = label_list->next;
-    }
-    return NULL;
+Label* find_label(const LabelTable *table, const char *name) {
+    return find_symbol_label(table, find_symbol(table->symbols, name));
 }
 
 /**
- * @brief Checks if a token matches any label in the label list.
+ * @brief Finds a label by the symbol ID of its name.
  *
- * @param token The token to check.
- * @param label_list The list of labels.
- * @return True if the token matches a label, otherwise false.
+ * This is the one place label lookups are counted.
+ *
+ * @param table The label table.
+ * @param symbol The symbol ID of the name, interned in the table's symbol table.
+ * @return A pointer to the found label, or NULL if the symbol names no label.
  */
-bool is_label(const char *token, Label *label_list) {
-    while (label_list != NULL) {
-        if (strcmp(label_list->name, token) == 0) {
-            return true;
-        }
-        label_list = label_list->next;
+Label* find_symbol_label(const LabelTable *table, int symbol) {
+    add_to_counter(COUNTER_LABEL_LOOKUPS, 1);
+    if (symbol < 0 || symbol >= table->capacity) {
+        return NULL;
     }
-    return false;
+    return table->slots[symbol];
 }
 
 /**
- * @brief Frees the memory allocated for the label list.
+ * @brief Frees the slot array of the label table.
  *
- * @param label_list The list of labels to free.
+ * The labels themselves live in the table's arena and are released along with it.
+ *
+ * @param table The label table to free.
  */
-void free_labels(Label *label_list) {
-    while (label_list != NULL) {
-        Label *next = label_list->next;
-        if (label_list->name != NULL) {
-            free(label_list->name);
-        }
-
-        free(label_list);
-        label_list = next;
-    }
+void free_labels(LabelTable *table) {
+    free(table->slots);
+    init_label_table(table, table->arena, table->symbols);
 }
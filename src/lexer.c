@@ -0,0 +1,182 @@
+/**
+ * @file lexer.c
+ * @brief Tokenizes assembly lines once into spans consumed by the parser.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "lexer.h"
+#include "stats.h"
+
+/* Characters that separate tokens */
+#define SEPARATORS " \t,\n"
+
+/**
+ * @brief Determines the role of a token when it starts a statement.
+ *
+ * The checks are ordered by precedence: a comment marker wins over a label colon,
+ * which wins over directives, which win over instructions. Substring searches are
+ * only run when the token holds the character every match must contain.
+ *
+ * @param text The null-terminated token text.
+ * @param length The length of the token.
+ * @param keyword The keyword the token is exactly, or NULL.
+ * @return The kind of the token.
+ */
+static TokenKind classify_token(const char *text, int length, const Keyword *keyword) {
+    bool has_dot, has_s;
+
+    if (text[0] == ';') {
+        return TOKEN_COMMENT;
+    } else if (memchr(text, ':', length) != NULL) {
+        return TOKEN_LABEL;
+    }
+
+    has_dot = memchr(text, '.', length) != NULL;
+    has_s = memchr(text, 's', length) != NULL;
+    if (has_dot && strstr(text, ".data") != NULL) {
+        return TOKEN_DATA;
+    } else if (has_dot && strstr(text, ".string") != NULL) {
+        return TOKEN_STRING;
+    } else if (has_dot && strstr(text, ".entry") != NULL) {
+        return TOKEN_ENTRY;
+    } else if (has_dot && strstr(text, ".extern") != NULL) {
+        return TOKEN_EXTERN;
+    } else if (has_s && (strstr(text, "stop") != NULL || strstr(text, "rts") != NULL)) {
+        return TOKEN_NO_OPERAND_INSTRUCTION;
+    } else if (keyword != NULL && keyword->directive == DIRECTIVE_NONE) {
+        return TOKEN_INSTRUCTION;
+    }
+    return TOKEN_OPERAND;
+}
+
+/**
+ * @brief Lexes tokens starting at an offset until the batch is full or the line ends.
+ *
+ * @param tokens Pointer to the LineTokens to fill.
+ * @param offset The offset in the text to start lexing from.
+ */
+static void lex_from(LineTokens *tokens, int offset) {
+    char *text = tokens->text;
+    bool line_start = (offset == 0);
+    Token *token;
+    const char *colon;
+    int start, length;
+
+    tokens->count = 0;
+    tokens->next_offset = -1;
+
+    while (offset < tokens->text_length) {
+        offset += strspn(text + offset, SEPARATORS);
+        if (offset >= tokens->text_length) {
+            break;
+        }
+        if (tokens->count == MAX_LINE_TOKENS) {
+            tokens->next_offset = offset;
+            break;
+        }
+
+        start = offset;
+        length = strcspn(text + start, SEPARATORS);
+        token = &tokens->tokens[tokens->count++];
+        token->offset = start;
+
+        /* A leading "LABEL:rest" is split after the colon, so "MAIN:inc r1" lexes like "MAIN: inc r1" */
+        colon = (line_start && tokens->count == 1 && text[start] != ';') ? memchr(text + start, ':', length) : NULL;
+        if (colon != NULL && colon < text + start + length - 1) {
+            token->length = (int)(colon - (text + start)) + 1;
+            token->keyword = NULL;
+            token->kind = TOKEN_LABEL;
+            text[start + token->length - 1] = NULL_TERMINATOR;  /* The colon, which handle_label strips anyway */
+            offset = start + token->length;
+            continue;
+        }
+
+        offset = start + length;
+        text[offset] = NULL_TERMINATOR;  /* Safe: text holds one byte past the line */
+        offset++;
+
+        token->length = length;
+        token->keyword = find_keyword(text + start, length);
+        token->kind = classify_token(text + start, length, token->keyword);
+    }
+}
+
+/**
+ * @brief Initializes an empty set of line tokens.
+ *
+ * @param tokens Pointer to the LineTokens to initialize.
+ */
+void init_line_tokens(LineTokens *tokens) {
+    tokens->text = NULL;
+    tokens->text_capacity = 0;
+    tokens->text_length = 0;
+    tokens->count = 0;
+    tokens->next_offset = -1;
+}
+
+/**
+ * @brief Tokenizes a line into its first batch of tokens.
+ *
+ * @param tokens Pointer to the LineTokens to fill.
+ * @param line The line to tokenize; it is not modified.
+ * @return True if the line was tokenized, false if memory allocation failed.
+ */
+bool lex_line(LineTokens *tokens, const char *line) {
+    int length = strlen(line);
+    char *text;
+
+    if (length + 1 > tokens->text_capacity) {
+        text = (char *)counted_realloc(tokens->text, length + 1);
+        if (text == NULL) {
+            tokens->count = 0;
+            return false;
+        }
+        tokens->text = text;
+        tokens->text_capacity = length + 1;
+    }
+
+    memcpy(tokens->text, line, length + 1);
+    tokens->text_length = length;
+    lex_from(tokens, 0);
+    return true;
+}
+
+/**
+ * @brief Replaces the current batch with the next batch of tokens of the same line.
+ *
+ * @param tokens Pointer to the LineTokens of a line previously passed to lex_line.
+ * @return True if more tokens were lexed, false if the line has no more tokens.
+ */
+bool lex_next_batch(LineTokens *tokens) {
+    if (tokens->next_offset < 0) {
+        tokens->count = 0;
+        return false;
+    }
+    lex_from(tokens, tokens->next_offset);
+    return tokens->count > 0;
+}
+
+/**
+ * @brief Returns the null-terminated text of a token.
+ *
+ * @param tokens Pointer to the LineTokens holding the token.
+ * @param index The index of the token in the current batch.
+ * @return The token text, or NULL if the index is past the end of the batch.
+ */
+char* token_text(const LineTokens *tokens, int index) {
+    if (index < 0 || index >= tokens->count) {
+        return NULL;
+    }
+    return tokens->text + tokens->tokens[index].offset;
+}
+
+/**
+ * @brief Frees the memory held by the line tokens.
+ *
+ * @param tokens Pointer to the LineTokens to free.
+ */
+void free_line_tokens(LineTokens *tokens) {
+    free(tokens->text);
+    init_line_tokens(tokens);
+}
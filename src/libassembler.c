@@ -0,0 +1,131 @@
+/**
+ * @file libassembler.c
+ * @brief Implements the in-memory interface of the assembler library.
+ *
+ * The sources go through the same preprocessor and passes as files on the command line;
+ * only the reading of the sources and the writing of the output files are left out.
+ */
+
+#include <stdlib.h>
+#include "libassembler.h"
+#include "assembler.h"
+#include "preprocessor.h"
+#include "file_manager.h"
+#include "buffer.h"
+#include "error.h"
+#include "stats.h"
+
+/**
+ * @brief Hands the contents of a buffer over to one of the fields of a result.
+ *
+ * @param buffer Pointer to the Buffer to release.
+ * @param contents Pointer to the field that receives the contents.
+ * @param length Pointer to the field that receives the length.
+ * @return true if the contents were handed over, false if memory allocation failed.
+ */
+static bool take_buffer(Buffer *buffer, char **contents, size_t *length) {
+    *contents = release_buffer(buffer, length);
+    return *contents != NULL;
+}
+
+/**
+ * @brief Assembles sources held in memory, as if they were files given on the command line.
+ *
+ * The sources are preprocessed one after another into a shared macro table, and are
+ * only assembled if all of them preprocess cleanly, as with the command-line assembler.
+ *
+ * @param sources The sources to assemble, in order.
+ * @param count The number of sources.
+ * @param result Pointer to the AssemblyResult to fill; free it with free_assembly_result.
+ * @return Non-zero if the sources were assembled without errors, zero otherwise.
+ */
+int assemble_buffers(const AssemblySource *sources, int count, AssemblyResult *result) {
+    int i;
+    bool success = true;
+    Context *contexts;
+    AssemblerContext assembler;
+    OutputFiles output;
+    Buffer diagnostics;
+    Buffer warnings;
+
+    result->object = NULL;
+    result->object_length = 0;
+    result->entries = NULL;
+    result->entries_length = 0;
+    result->externs = NULL;
+    result->externs_length = 0;
+    result->diagnostics = NULL;
+    result->diagnostics_length = 0;
+    result->warnings = NULL;
+    result->warnings_length = 0;
+    result->error_count = 0;
+
+    init_assembler_context(&assembler);
+    init_output_files(&output);
+    init_buffer(&diagnostics);
+    init_buffer(&warnings);
+    assembler.warnings = &warnings;  /* Collected rather than printed to the host's stderr */
+
+    contexts = (Context *)counted_malloc((count > 0 ? count : 1) * sizeof(Context));
+    if (contexts == NULL) {
+        add_error(&assembler.errors, ERR_MEMORY_ALLOCATION_FAILED, "", 0, NULL);
+        success = false;
+        count = 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!preprocess_text(sources[i].name, sources[i].text, sources[i].length, &contexts[i], &assembler)) {
+            success = false;
+        }
+    }
+
+    if (success) {
+        success = assemble_to_output(count, contexts, &assembler, 1, &output);
+    }
+
+    result->error_count = assembler.errors.count;
+    if (!format_errors(&assembler.errors, &diagnostics)) {
+        success = false;
+    }
+    if (!take_buffer(&output.object, &result->object, &result->object_length)
+            || !take_buffer(&output.entries, &result->entries, &result->entries_length)
+            || !take_buffer(&output.externs, &result->externs, &result->externs_length)
+            || !take_buffer(&diagnostics, &result->diagnostics, &result->diagnostics_length)
+            || !take_buffer(&warnings, &result->warnings, &result->warnings_length)) {
+        success = false;
+    }
+
+    for (i = 0; i < count; i++) {
+        free_context(&contexts[i]);
+    }
+    free(contexts);
+    free_output_files(&output);
+    free_buffer(&diagnostics);
+    free_buffer(&warnings);
+    free_assembler_context(&assembler);
+    return success ? 1 : 0;
+}
+
+/**
+ * @brief Frees the buffers of an assembly result.
+ *
+ * @param result Pointer to the AssemblyResult to free.
+ */
+void free_assembly_result(AssemblyResult *result) {
+    free(result->object);
+    free(result->entries);
+    free(result->externs);
+    free(result->diagnostics);
+    free(result->warnings);
+    result->object = NULL;
+    result->object_length = 0;
+    result->entries = NULL;
+    result->entries_length = 0;
+    result->externs = NULL;
+    result->externs_length = 0;
+    result->diagnostics = NULL;
+    result->diagnostics_length = 0;
+    result->warnings = NULL;
+    result->warnings_length = 0;
+    result->error_count = 0;
+}
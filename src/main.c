@@ -3,23 +3,26 @@
  * @brief The entry point of the assembler program.
  *
  * This file handles the command-line arguments, manages the flow of the assembly process,
- * and handles the creation of output files (.ob, .ext, .ent). It also manages error handling
- * and memory cleanup.
+ * and handles the creation of output files (.ob, .ext, .ent). It also starts the assembler
+ * server, sends builds to one when asked to, and reuses cached builds.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include "assembler.h"
-#include "preprocessor.h"
+#include "build.h"
+#include "cache.h"
 #include "error.h"
 #include "file_manager.h"
+#include "options.h"
+#include "server.h"
+#include "stats.h"
 
 /**
  * @brief The main function of the assembler program.
  *
  * This function is the entry point of the program. It processes command-line arguments,
- * initiates preprocessing, assembly, and handles the generation of output files.
+ * builds the files locally or on a server, and writes the output files of the build.
  *
  * @param argc The number of command-line arguments.
  * @param argv The array of command-line arguments.
@@ -27,71 +30,68 @@
  */
 int main(int argc, char *argv[]) {
     const char **filenames;
-    int i, file_count;
-    bool success;
-    Context *contexts;
+    int file_count, first_file;
+    bool success, cacheable;
+    CacheKey key;
+    ErrorList errors;
+    BuildResult result;
+    Options options;
+    Stats stats;
 
-    /* Check if at least one source file is provided */
-    if (argc < 2) {
-        printf("Usage: %s <sourcefile>\n", argv[0]);
+    if (!parse_options(argc, argv, &options, &first_file)) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    /* Initialize error handling */
-    init_error_handling();
-
-    /* Prepare filenames for processing */
-    if (!prepare_filenames(argc, argv, &filenames, &file_count)) {
-        print_errors();
-        free_errors();
-        return 1;
+    /* A server takes its sources from its clients */
+    if (options.serve_socket != NULL) {
+        return serve(options.serve_socket, options.jobs, options.single_pass) ? 0 : 1;
     }
 
-    /* Allocate memory for contexts */
-    contexts = (Context *)malloc(file_count * sizeof(Context));
-    if (contexts == NULL) {
-        fprintf(stderr, "Failed to allocate memory for contexts.\n");
-        free_filenames(filenames, file_count);
+    /* Check if at least one source file is provided */
+    if (first_file >= argc) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    /* Preprocess all files */
-    success = preprocess_all_files(file_count, filenames, contexts);
-
-    if (!success) {
-        print_errors();
-        printf("Assembly failed due to errors.\n");
-    } else {
-        /* Delete previous output files if they exist */
-        delete_output_files(filenames, file_count);
-
-        /* Create preprocessed files from the contexts */
-        create_preprocessed_files(file_count, contexts);
+    init_stats(&stats);
+    if (options.print_stats) {
+        enable_stats(&stats);
+    }
 
-        /* Fix the filenames after preprocessing */
-        fix_filenames(filenames, file_count);
+    init_error_handling(&errors);
 
-        /* Perform the assembly process */
-        success = assemble(file_count, filenames);
+    /* Prepare filenames for processing */
+    if (!prepare_filenames(argc - first_file, argv + first_file, &filenames, &file_count, &errors)) {
+        print_errors(&errors);
+        free_errors(&errors);
+        return 1;
+    }
 
-        if (has_errors()) {
-            print_errors();
-            printf("Assembly failed due to errors.\n");
-        } else {
-            printf("Assembly completed successfully for all files.\n");
+    /* Reuse the result of an earlier run on the same inputs if the cache holds one */
+    init_build_result(&result);
+    cacheable = options.cache_dir != NULL && make_cache_key(file_count, filenames, options.max_errors, &key);
+    if (!cacheable || !load_cached_build(options.cache_dir, &key, file_count, &result)) {
+        /* Build on the server if one is given and reachable, otherwise in this process */
+        if (options.client_socket == NULL || !request_build(options.client_socket, file_count, filenames, options.max_errors, &result)) {
+            build_files(file_count, filenames, options.jobs, options.single_pass, options.max_errors, &result);
+        }
+        if (cacheable) {
+            store_cached_build(options.cache_dir, &key, &result);
         }
     }
-
-    /* Free allocated memory for contexts and filenames */
-    for (i = 0; i < file_count; i++) {
-        free_context(&contexts[i]);
+    if (options.cache_dir != NULL) {
+        free_cache_key(&key);
     }
-    free(contexts);
+
+    /* Write the .am and output files and print the messages of the build */
+    success = report_build(file_count, filenames, &result, options.write_preprocessed);
+
+    free_build_result(&result);
     free_filenames(filenames, file_count);
+    free_errors(&errors);
 
-    /* Free resources used for macro processing and error handling */
-    free_macros();
-    free_errors();
+    print_stats(&stats);
 
     return success ? 0 : 1;
 }
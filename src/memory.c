@@ -11,129 +11,352 @@
 #include <string.h>
 #include "memory.h"
 #include "utils.h"
+#include "arena.h"
+#include "stats.h"
+#include "error.h"
+#include "buffer.h"
+
+#define INITIAL_WORD_CAPACITY 256
+#define INITIAL_FIXUP_CAPACITY 64
+#define INITIAL_EVENT_CAPACITY 64
+#define INITIAL_RUN_CAPACITY 64
 
 /**
- * @brief Initializes the memory structure, setting all memory cells to zero and resetting counters.
+ * @brief Appends a word to a word buffer, doubling its capacity when full.
+ *
+ * @param buffer Pointer to the WordBuffer to append to.
+ * @param word The word to append.
+ * @return True if the word was appended, false if memory allocation fails.
+ */
+static bool append_word(WordBuffer *buffer, Word word) {
+    Word *words;
+    int capacity;
+
+    if (buffer->count >= buffer->capacity) {
+        capacity = (buffer->capacity == 0) ? INITIAL_WORD_CAPACITY : buffer->capacity * 2;
+        words = (Word *)counted_realloc(buffer->words, capacity * sizeof(Word));
+        if (words == NULL) {
+            return false;
+        }
+        buffer->words = words;
+        buffer->capacity = capacity;
+    }
+    buffer->words[buffer->count++] = word;
+    return true;
+}
+
+/**
+ * @brief Frees the words of a word buffer.
+ *
+ * @param buffer Pointer to the WordBuffer to free.
+ */
+static void free_words(WordBuffer *buffer) {
+    free(buffer->words);
+    buffer->words = NULL;
+    buffer->count = 0;
+    buffer->capacity = 0;
+}
+
+/**
+ * @brief Initializes the memory structure, emptying the images and resetting counters.
  *
  * @param mem Pointer to the Memory structure to initialize.
  */
 void initialize_memory(Memory *mem) {
-    int i;
-    for (i = 0; i < MEMORY_SIZE; i++) {
-        mem->memory[i] = 0;
-    }
     mem->IC = 0;
-    mem->DC = 100;
+    mem->DC = INITIAL_DC;
     mem->current_line_number = 0;
-    mem->instructionList = NULL;
-    mem->dataList = NULL;
-    mem->label_list = NULL;
+    mem->instructions.words = NULL;
+    mem->instructions.count = 0;
+    mem->instructions.capacity = 0;
+    mem->data.words = NULL;
+    mem->data.count = 0;
+    mem->data.capacity = 0;
+    mem->fixups.fixups = NULL;
+    mem->fixups.count = 0;
+    mem->fixups.capacity = 0;
+    init_arena(&mem->arena);
+    init_symbol_table(&mem->symbols, &mem->arena);
+    init_label_table(&mem->labels, &mem->arena, &mem->symbols);
     mem->current_line = NULL;
     mem->current_file = NULL;
+    mem->macros = NULL;
+    mem->errors = NULL;
+    mem->warnings = NULL;
+    mem->isolated = false;
+    mem->single_pass = false;
+    mem->label_log.events = NULL;
+    mem->label_log.count = 0;
+    mem->label_log.capacity = 0;
+    mem->counter_log.runs = NULL;
+    mem->counter_log.count = 0;
+    mem->counter_log.capacity = 0;
 }
 
 /**
- * @brief Writes a word to the specified memory address and updates the corresponding linked list.
+ * @brief Appends a word to the instruction or data image, at the address of the current counter.
+ *
+ * Every word is followed by one increment of its counter, so the word's index in its
+ * image determines its address.
  *
  * @param mem Pointer to the Memory structure.
- * @param address The memory address to write to.
  * @param word The word to write to memory.
  * @param isInstruction Flag indicating whether the word is an instruction (1) or data (0).
- * @param label_name The name of the label associated with the memory word, if any.
+ * @return True if the word was stored, false if memory allocation failed.
  */
-void write_to_memory(Memory *mem, int address, Word word, int isInstruction, char *label_name) {
-    ListNode **list;
-    ListNode *newNode = (ListNode *)malloc(sizeof(ListNode));
-    if (!newNode) {
+bool write_to_memory(Memory *mem, Word word, int isInstruction) {
+    if (!append_word(isInstruction ? &mem->instructions : &mem->data, (Word)(word & 0x7FFF))) {  /* Mask to 15 bits */
         fprintf(stderr, "Memory allocation error in write_to_memory\n");
-        return;
+        return false;
     }
+    return true;
+}
 
-    newNode->data = word & 0x7FFF;  /* Mask to 15 bits */
-    newNode->address = address;
-    newNode->label_name = str_duplicate(label_name);
-    newNode->next = NULL;
+/**
+ * @brief Computes the final address of a word of the instruction image.
+ *
+ * The Instruction Counter stops at the end of memory, so words past it share its
+ * last address.
+ *
+ * @param index The index of the word in the instruction image.
+ * @return The address of the word.
+ */
+int instruction_address(int index) {
+    return ((index < MEMORY_SIZE) ? index : MEMORY_SIZE) + LOAD_ADDRESS;
+}
 
-    list = isInstruction ? &(mem->instructionList) : &(mem->dataList);
-    if (*list == NULL) {
-        *list = newNode;
-    } else {
-        ListNode *current = *list;
-        while (current->next != NULL) {
-            current = current->next;
+/**
+ * @brief Computes the final address of a word of the data image, which follows the instruction image.
+ *
+ * The Data Counter starts at INITIAL_DC and stops at the end of memory, so words past
+ * it share its last address.
+ *
+ * @param mem Pointer to the Memory structure, whose Instruction Counter is final.
+ * @param index The index of the word in the data image.
+ * @return The address of the word.
+ */
+int data_address(const Memory *mem, int index) {
+    index += INITIAL_DC;
+    return ((index < MEMORY_SIZE) ? index : MEMORY_SIZE) + mem->IC;
+}
+
+/**
+ * @brief Records that an instruction word refers to a label and must be patched with its address.
+ *
+ * The fixup is also chained onto the label's earlier fixups, so the references to one
+ * label can be patched without walking the others.
+ *
+ * @param mem Pointer to the Memory structure.
+ * @param word_index The index of the word in the instruction buffer.
+ * @param label The referenced label.
+ */
+void add_fixup(Memory *mem, int word_index, Label *label) {
+    FixupBuffer *buffer = &mem->fixups;
+    Fixup *fixups;
+    int capacity;
+
+    if (buffer->count >= buffer->capacity) {
+        capacity = (buffer->capacity == 0) ? INITIAL_FIXUP_CAPACITY : buffer->capacity * 2;
+        fixups = (Fixup *)counted_realloc(buffer->fixups, capacity * sizeof(Fixup));
+        if (fixups == NULL) {
+            fprintf(stderr, "Memory allocation error in add_fixup\n");
+            return;
+        }
+        buffer->fixups = fixups;
+        buffer->capacity = capacity;
+    }
+    buffer->fixups[buffer->count].word_index = word_index;
+    buffer->fixups[buffer->count].label = label;
+    buffer->fixups[buffer->count].next = label->fixup_chain;
+    label->fixup_chain = buffer->count;
+    buffer->count++;
+}
+
+/**
+ * @brief Records a label operation to be replayed once the labels of earlier files are known.
+ *
+ * The event keeps the current line and how many errors were reported before it, so
+ * replaying the events can report their errors in their original place.
+ *
+ * @param mem Pointer to the Memory structure.
+ * @param kind What happened to the label.
+ * @param symbol The symbol ID of the label name.
+ * @param address The address of a declared label.
+ * @param is_instruction Whether a declared label is associated with an instruction.
+ * @param word_index Index of a referencing word in the instruction buffer, or -1.
+ */
+void add_label_event(Memory *mem, LabelEventKind kind, int symbol, int address, bool is_instruction, int word_index) {
+    LabelLog *log = &mem->label_log;
+    LabelEvent *events;
+    LabelEvent *event;
+    int capacity;
+
+    if (log->count >= log->capacity) {
+        capacity = (log->capacity == 0) ? INITIAL_EVENT_CAPACITY : log->capacity * 2;
+        events = (LabelEvent *)counted_realloc(log->events, capacity * sizeof(LabelEvent));
+        if (events == NULL) {
+            fprintf(stderr, "Memory allocation error in add_label_event\n");
+            return;
+        }
+        log->events = events;
+        log->capacity = capacity;
+    }
+    event = &log->events[log->count];
+    event->symbol = symbol;
+    event->kind = kind;
+    event->line_number = mem->current_line_number;
+    event->address = address;
+    event->is_instruction = is_instruction;
+    event->word_index = word_index;
+    event->error_count = mem->errors->count;
+    log->count++;
+}
+
+/**
+ * @brief Records an increment of one of the counters of an isolated memory.
+ *
+ * Consecutive increments of the same counter share a run, so the log stays small.
+ *
+ * @param mem Pointer to the Memory structure.
+ * @param data Whether the Data Counter is incremented rather than the Instruction Counter.
+ */
+static void log_increment(Memory *mem, bool data) {
+    CounterLog *log = &mem->counter_log;
+    CounterRun *runs;
+    int capacity;
+
+    if (log->count > 0 && log->runs[log->count - 1].data == data) {
+        log->runs[log->count - 1].count++;
+        return;
+    }
+    if (log->count >= log->capacity) {
+        capacity = (log->capacity == 0) ? INITIAL_RUN_CAPACITY : log->capacity * 2;
+        runs = (CounterRun *)counted_realloc(log->runs, capacity * sizeof(CounterRun));
+        if (runs == NULL) {
+            fprintf(stderr, "Memory allocation error in log_increment\n");
+            return;
         }
-        current->next = newNode;
+        log->runs = runs;
+        log->capacity = capacity;
+    }
+    log->runs[log->count].data = data;
+    log->runs[log->count].count = 1;
+    log->count++;
+}
+
+/**
+ * @brief Reports a counter overflow warning.
+ *
+ * @param mem Pointer to the Memory structure.
+ * @param message The warning, including its newline.
+ */
+static void report_overflow(Memory *mem, const char *message) {
+    if (mem->warnings != NULL) {
+        buffer_append_string(mem->warnings, message);
+    } else {
+        fputs(message, stderr);
     }
 }
 
 /**
  * @brief Increments the Instruction Counter (IC).
  *
+ * An isolated memory is not limited here; its increments are logged so that any
+ * overflow can be reported once the files before it are known.
+ *
  * @param mem Pointer to the Memory structure.
  */
 void increment_IC(Memory *mem) {
-    if (mem->IC < MEMORY_SIZE) {
+    if (mem->isolated) {
+        log_increment(mem, false);
+        mem->IC++;
+    } else if (mem->IC < MEMORY_SIZE) {
         mem->IC++;
     } else {
-        fprintf(stderr, "Instruction Counter overflow\n");
+        report_overflow(mem, "Instruction Counter overflow\n");
     }
 }
 
 /**
  * @brief Increments the Data Counter (DC).
  *
+ * An isolated memory is not limited here; its increments are logged so that any
+ * overflow can be reported once the files before it are known.
+ *
  * @param mem Pointer to the Memory structure.
  */
 void increment_DC(Memory *mem) {
-    if (mem->DC < MEMORY_SIZE) {
+    if (mem->isolated) {
+        log_increment(mem, true);
+        mem->DC++;
+    } else if (mem->DC < MEMORY_SIZE) {
         mem->DC++;
     } else {
-        fprintf(stderr, "Data Counter overflow\n");
+        report_overflow(mem, "Data Counter overflow\n");
     }
 }
 
 /**
- * @brief Clears all memory, including the instruction list, data list, and labels.
+ * @brief Reports the overflow warnings the increments of an isolated memory would have reported.
  *
- * @param mem Pointer to the Memory structure to clear.
+ * The logged increments are replayed from the given counters, so the warnings come out
+ * in the same order as if the file had been parsed after the files before it.
+ *
+ * @param mem Pointer to the Memory structure the warnings are reported for.
+ * @param part Pointer to the isolated Memory structure.
+ * @param IC The Instruction Counter its increments would have started from.
+ * @param DC The Data Counter its increments would have started from.
  */
-void clear_memory(Memory *mem) {
-    ListNode *current = mem->instructionList;
-    while (current != NULL) {
-        ListNode *temp = current;
-        if (temp->label_name != NULL) {
-            free(temp->label_name);
-            temp->label_name = NULL;
-        }
-        current = current->next;
-        free(temp);
-    }
-    mem->instructionList = NULL;
-
-    current = mem->dataList;
-    while (current != NULL) {
-        ListNode *temp = current;
-        if (temp->label_name != NULL) {
-            free(temp->label_name);
-            temp->label_name = NULL;
+void report_counter_overflows(Memory *mem, const Memory *part, int IC, int DC) {
+    const CounterRun *run;
+    int *counter;
+    int i, k;
+
+    for (i = 0; i < part->counter_log.count; i++) {
+        run = &part->counter_log.runs[i];
+        counter = run->data ? &DC : &IC;
+        for (k = 0; k < run->count; k++) {
+            if (*counter < MEMORY_SIZE) {
+                (*counter)++;
+            } else {
+                report_overflow(mem, run->data ? "Data Counter overflow\n" : "Instruction Counter overflow\n");
+            }
         }
-        current = current->next;
-        free(temp);
     }
-    mem->dataList = NULL;
+}
+
+/**
+ * @brief Clears all memory, including the instruction buffer, data buffer, fixups, and labels.
+ *
+ * @param mem Pointer to the Memory structure to clear.
+ */
+void clear_memory(Memory *mem) {
+    free_words(&mem->instructions);
+    free_words(&mem->data);
 
-    free_labels(mem->label_list);
-    mem->label_list = NULL;
+    free(mem->fixups.fixups);
+    mem->fixups.fixups = NULL;
+    mem->fixups.count = 0;
+    mem->fixups.capacity = 0;
 
-    if (mem->current_line != NULL) {
-        free(mem->current_line);
-        mem->current_line = NULL;
-    }
+    free(mem->label_log.events);
+    mem->label_log.events = NULL;
+    mem->label_log.count = 0;
+    mem->label_log.capacity = 0;
 
-    if (mem->current_file != NULL) {
-        free(mem->current_file);
-        mem->current_file = NULL;
-    }
+    free(mem->counter_log.runs);
+    mem->counter_log.runs = NULL;
+    mem->counter_log.count = 0;
+    mem->counter_log.capacity = 0;
+
+    free_labels(&mem->labels);
+    free_symbol_table(&mem->symbols);
+
+    /* Labels, label names and file names all go with the arena */
+    free_arena(&mem->arena);
+
+    mem->current_line = NULL;
+    mem->current_file = NULL;
 
     mem->IC = 0;
     mem->DC = 0;
@@ -144,11 +367,11 @@ void clear_memory(Memory *mem) {
  * @brief Converts a word to its binary representation.
  *
  * @param word The word to convert.
- * @return A string representing the binary value of the word.
+ * @param binary Buffer of at least WORD_SIZE + 1 characters that receives the string.
+ * @return The binary buffer, holding the binary value of the word.
  */
-char* word_to_binary(Word word) {
+char* word_to_binary(Word word, char *binary) {
     int i;
-    static char binary[WORD_SIZE + 1];
     binary[WORD_SIZE] = '\0';
     for (i = WORD_SIZE - 1; i >= 0; i--) {
         binary[i] = (word & 1) ? '1' : '0';
@@ -163,62 +386,27 @@ char* word_to_binary(Word word) {
  * @param mem Pointer to the Memory structure.
  */
 void print_memory(const Memory *mem) {
-    ListNode *node;
-    Label *label = mem->label_list;
+    int i;
+    char binary[WORD_SIZE + 1];
+    Label *label;
     printf("Instructions:\n");
-    for (node = mem->instructionList; node != NULL; node = node->next) {
-        printf("Address %04d: %s %s\n", node->address, word_to_binary(node->data), node->label_name);
+    for (i = 0; i < mem->instructions.count; i++) {
+        printf("Address %04d: %s\n", instruction_address(i), word_to_binary(mem->instructions.words[i], binary));
     }
     printf("Data:\n");
-    for (node = mem->dataList; node != NULL; node = node->next) {
-        printf("Address %04d: %s\n", node->address, word_to_binary(node->data));
+    for (i = 0; i < mem->data.count; i++) {
+        printf("Address %04d: %s\n", data_address(mem, i), word_to_binary(mem->data.words[i], binary));
+    }
+
+    printf("Fixups:\n");
+    for (i = 0; i < mem->fixups.count; i++) {
+        printf("Address %04d: %s\n", instruction_address(mem->fixups.fixups[i].word_index), mem->fixups.fixups[i].label->name);
     }
 
     printf("Labels:\n");
-    for (label = mem->label_list; label != NULL; label = label->next) {
+    for (label = mem->labels.head; label != NULL; label = label->next) {
         printf("name: %s: address: %04d entry:%d external: %d instruction: %d declared: %d declared in file: %s\n",
                label->name, label->address, label->entry, label->external, label->is_instruction,
                label->declared, label->file_name ? label->file_name : "NULL");
     }
 }
-
-/**
- * @brief Stores the current line in memory, freeing any previously stored line.
- *
- * @param mem Pointer to the Memory structure.
- * @param line The line to store.
- */
-void write_current_line(Memory *mem, char *line) {
-    if (mem->current_line != NULL) {
-        free(mem->current_line);
-        mem->current_line = NULL;
-    }
-    mem->current_line = str_duplicate(line);
-}
-
-/**
- * @brief Moves to the next word in the current line, updating the current_line pointer.
- *
- * @param mem Pointer to the Memory structure.
- */
-void move_to_next_word(Memory *mem) {
-    int i;
-    char *new_line = str_duplicate(mem->current_line);
-
-    for (i = 0; i < strlen(new_line); i++) {
-        if (new_line[i] == ':') {
-            new_line += i + 1;
-            break;
-        }
-    }
-
-    while (*new_line == ' ' || *new_line == '\t') {
-        new_line++;
-    }
-
-    if (mem->current_line != NULL) {
-        free(mem->current_line);
-    }
-
-    mem->current_line = str_duplicate(new_line);
-}
@@ -1,59 +1,88 @@
 #include <string.h>
 #include "operations.h"
 
+#define KEYWORD_SLOTS 64
+
 /**
- * @brief Array of supported operations and their corresponding opcodes.
+ * @brief Array of supported operations and directives.
  *
- * This array contains the supported assembly operations (mnemonics) and their associated
- * opcodes. The operations are used during the assembly process to translate mnemonics into
- * machine code.
+ * The operations are listed in opcode order, so the first NUM_OPERATIONS entries can be
+ * indexed by opcode. Each operation records the addressing modes its source and
+ * destination operands accept; directives accept none.
  */
-static const Operation operations[NUM_OPERATIONS] = {
-        {"mov", 0x00},
-        {"cmp", 0x01},
-        {"add", 0x02},
-        {"sub", 0x03},
-        {"lea", 0x04},
-        {"clr", 0x05},
-        {"not", 0x06},
-        {"inc", 0x07},
-        {"dec", 0x08},
-        {"jmp", 0x09},
-        {"bne", 0x0A},
-        {"red", 0x0B},
-        {"prn", 0x0C},
-        {"jsr", 0x0D},
-        {"rts", 0x0E},
-        {"stop", 0x0F}
+static const Keyword keywords[] = {
+        {"mov",  OP_MOV,  2, DIRECTIVE_NONE, ALL_MODES,   WRITABLE_MODES},
+        {"cmp",  OP_CMP,  2, DIRECTIVE_NONE, ALL_MODES,   ALL_MODES},
+        {"add",  OP_ADD,  2, DIRECTIVE_NONE, ALL_MODES,   WRITABLE_MODES},
+        {"sub",  OP_SUB,  2, DIRECTIVE_NONE, ALL_MODES,   WRITABLE_MODES},
+        {"lea",  OP_LEA,  2, DIRECTIVE_NONE, DIRECT_MODE, WRITABLE_MODES},
+        {"clr",  OP_CLR,  1, DIRECTIVE_NONE, NO_MODES,    WRITABLE_MODES},
+        {"not",  OP_NOT,  1, DIRECTIVE_NONE, NO_MODES,    WRITABLE_MODES},
+        {"inc",  OP_INC,  1, DIRECTIVE_NONE, NO_MODES,    WRITABLE_MODES},
+        {"dec",  OP_DEC,  1, DIRECTIVE_NONE, NO_MODES,    WRITABLE_MODES},
+        {"jmp",  OP_JMP,  1, DIRECTIVE_NONE, NO_MODES,    REGISTER_MODES},
+        {"bne",  OP_BNE,  1, DIRECTIVE_NONE, NO_MODES,    REGISTER_MODES},
+        {"red",  OP_RED,  1, DIRECTIVE_NONE, NO_MODES,    WRITABLE_MODES},
+        {"prn",  OP_PRN,  1, DIRECTIVE_NONE, NO_MODES,    ALL_MODES},
+        {"jsr",  OP_JSR,  1, DIRECTIVE_NONE, NO_MODES,    REGISTER_MODES},
+        {"rts",  OP_RTS,  0, DIRECTIVE_NONE, NO_MODES,    NO_MODES},
+        {"stop", OP_STOP, 0, DIRECTIVE_NONE, NO_MODES,    NO_MODES},
+        {".data",   INVALID_OPCODE, -1, DIRECTIVE_DATA,   NO_MODES, NO_MODES},
+        {".string", INVALID_OPCODE, -1, DIRECTIVE_STRING, NO_MODES, NO_MODES},
+        {".entry",  INVALID_OPCODE, -1, DIRECTIVE_ENTRY,  NO_MODES, NO_MODES},
+        {".extern", INVALID_OPCODE, -1, DIRECTIVE_EXTERN, NO_MODES, NO_MODES}
 };
 
 /**
- * @brief Retrieve the array of supported operations.
- *
- * This function returns a pointer to the array of supported operations, which can be used
- * to look up the opcode associated with a given mnemonic.
+ * @brief Perfect hash of the keywords: slot -> index in keywords[], or -1.
  *
- * @return A pointer to the array of supported operations.
+ * A keyword lands in slot (name[0] + 2 * name[2] + length) % KEYWORD_SLOTS, and no two
+ * keywords share a slot. The coefficients were found by exhaustive search; if a keyword
+ * is added, search again for coefficients that keep the slots distinct.
  */
-const Operation* get_operations() {
-    return operations;
-}
+static const signed char keyword_slots[KEYWORD_SLOTS] = {
+        -1, -1, -1, -1, -1, -1,  1, -1, -1, -1,  5, -1, -1,  9, -1, 12,
+        18, 13, -1, -1, -1, 15, -1, -1, -1,  6, -1, 14,  0, 17, -1, -1,
+        -1, -1, -1, -1, -1, 19, -1, -1, -1, -1, -1, -1,  2,  8, -1, 10,
+        -1,  4,  7, -1, -1, 16, -1, -1, -1, -1,  3, -1, -1, 11, -1, -1
+};
 
 /**
- * @brief Get the opcode for a given mnemonic.
+ * @brief Looks up a token among the mnemonics and directives with a single hash probe.
  *
- * This function searches for the specified mnemonic in the operations array and returns the
- * corresponding opcode. If the mnemonic is not found, it returns 0xFFFF to indicate an invalid opcode.
+ * Every keyword is at least three characters long, so shorter tokens are rejected
+ * before hashing.
  *
- * @param mnemonic The mnemonic to look up.
- * @return The opcode associated with the mnemonic, or 0xFFFF if the mnemonic is invalid.
+ * @param token The token to look up; it does not need to be null-terminated.
+ * @param length The length of the token.
+ * @return The matching keyword, or NULL if the token is not a keyword.
  */
-unsigned short get_opcode(const char *mnemonic) {
-    int i;
-    for (i = 0; i < NUM_OPERATIONS; i++) {
-        if (strcmp(operations[i].mnemonic, mnemonic) == 0) {
-            return operations[i].opcode;
-        }
+const Keyword* find_keyword(const char *token, size_t length) {
+    const Keyword *keyword;
+    int index;
+
+    if (length < 3 || length > 7) {
+        return NULL;
+    }
+
+    index = keyword_slots[((unsigned char) token[0] + 2 * (unsigned char) token[2] + length) % KEYWORD_SLOTS];
+    if (index < 0) {
+        return NULL;
     }
-    return 0xFFFF; /* Invalid opcode */
+
+    keyword = &keywords[index];
+    if (strncmp(keyword->name, token, length) != 0 || keyword->name[length] != '\0') {
+        return NULL;
+    }
+    return keyword;
+}
+
+/**
+ * @brief Gets the operation with the given opcode.
+ *
+ * @param opcode The opcode to look up.
+ * @return The operation keyword, or NULL if the opcode is out of range.
+ */
+const Keyword* get_operation(unsigned short opcode) {
+    return opcode < NUM_OPERATIONS ? &keywords[opcode] : NULL;
 }
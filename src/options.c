@@ -0,0 +1,141 @@
+/**
+ * @file options.c
+ * @brief Parses the command-line options accepted by the assembler.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "options.h"
+
+/**
+ * @brief Parses the count given to an option.
+ *
+ * @param text The text of the count.
+ * @param limit The largest count accepted.
+ * @param count Pointer to store the count.
+ * @return True if the text is a positive number no larger than the limit, false otherwise.
+ */
+static bool parse_count(const char *text, long limit, int *count) {
+    char *end;
+    long value;
+
+    if (text == NULL || *text == '\0') {
+        return false;
+    }
+    value = strtol(text, &end, 10);
+    if (*end != '\0' || value < 1 || value > limit) {
+        return false;
+    }
+    *count = (int) value;
+    return true;
+}
+
+/**
+ * @brief Parses the path that follows an option.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The list of command-line arguments.
+ * @param index Pointer to the index of the option; it is moved to the path.
+ * @param path Pointer to store the path.
+ * @return True if a path follows the option, false otherwise.
+ */
+static bool parse_path(int argc, char *argv[], int *index, const char **path) {
+    if (*index + 1 >= argc) {
+        fprintf(stderr, "Missing path for %s\n", argv[*index]);
+        return false;
+    }
+    *path = argv[++*index];
+    return true;
+}
+
+/**
+ * @brief Parses the leading options from the command-line arguments.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The list of command-line arguments.
+ * @param options Pointer to the Options structure to fill.
+ * @param first_file Pointer to store the index of the first source file argument.
+ * @return True if all options were recognized and can be combined, false otherwise.
+ */
+bool parse_options(int argc, char *argv[], Options *options, int *first_file) {
+    int i;
+    bool jobs_given = false;
+
+    options->write_preprocessed = true;
+    options->print_stats = false;
+    options->jobs = 1;
+    options->single_pass = false;
+    options->max_errors = 0;
+    options->serve_socket = NULL;
+    options->client_socket = NULL;
+    options->cache_dir = NULL;
+
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            i++;
+            break;
+        } else if (strcmp(argv[i], "--no-am") == 0) {
+            options->write_preprocessed = false;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options->print_stats = true;
+        } else if (strcmp(argv[i], "--single-pass") == 0) {
+            options->single_pass = true;
+        } else if (strcmp(argv[i], "--max-errors") == 0) {
+            if (!parse_count(argv[++i], MAX_ERROR_LIMIT, &options->max_errors)) {
+                fprintf(stderr, "Invalid error limit for --max-errors\n");
+                return false;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            if (!parse_path(argc, argv, &i, &options->serve_socket)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--client") == 0) {
+            if (!parse_path(argc, argv, &i, &options->client_socket)) {
+                return false;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            if (!parse_path(argc, argv, &i, &options->cache_dir)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            /* Accept both "-j N" and "-jN" */
+            if (!parse_count(argv[i][2] != '\0' ? argv[i] + 2 : argv[++i], MAX_JOBS, &options->jobs)) {
+                fprintf(stderr, "Invalid job count for -j\n");
+                return false;
+            }
+            jobs_given = true;
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            return false;
+        }
+    }
+
+    /* A server builds with the -j and --single-pass it was started with */
+    if (options->client_socket != NULL && (jobs_given || options->single_pass)) {
+        fprintf(stderr, "--client cannot be combined with -j or --single-pass; pass them to --serve instead\n");
+        return false;
+    }
+
+    *first_file = i;
+    return true;
+}
+
+/**
+ * @brief Prints the command-line usage of the assembler.
+ *
+ * @param program The name the program was invoked with.
+ */
+void print_usage(const char *program) {
+    printf("Usage: %s [options] <sourcefile> [<sourcefile> ...]\n", program);
+    printf("       %s [-j N] [--single-pass] --serve <socket>\n", program);
+    printf("Options:\n");
+    printf("  --no-am    Do not write the preprocessed sources to .am files\n");
+    printf("  --stats    Print per-stage wall times and counters to stderr\n");
+    printf("  -j N       Preprocess and parse the files on N threads\n");
+    printf("  --single-pass  Patch label references as labels are declared, skipping the second pass\n");
+    printf("  --max-errors N Stop assembling after N errors\n");
+    printf("  --serve S  Serve builds on the Unix domain socket S\n");
+    printf("  --client S Build on the server at socket S, or locally if it cannot be reached\n");
+    printf("  --cache D  Reuse the outputs of earlier runs on identical inputs, kept in directory D\n");
+}
@@ -18,6 +18,8 @@
 #include "operations.h"
 #include "validations.h"
 #include "constants.h"
+#include "lexer.h"
+#include "stats.h"
 
 /**
  * @brief Converts an integer to a 15-bit binary word (2's complement for negatives).
@@ -35,87 +37,79 @@ Word int_to_word(int value) {
 /**
  * @brief Parses a .data directive and stores its values in memory.
  *
- * @param current_token The current token being processed.
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the .data token.
  * @param mem Pointer to the Memory structure.
  */
-void handle_data_directive(const char *current_token, Memory *mem) {
+void handle_data_directive(LineTokens *tokens, int index, Memory *mem) {
     Word word;
     int value;
-    char *token = strtok(mem->current_line, "\t ,");
-    while (strcmp(token, current_token) != 0) {
-        token = strtok(NULL, "\t ,");
-    }
-    token = strtok(NULL, "\t ,");
-    while (token != NULL) {
-        if (!validate_data(token)) {
-            add_error(ERR_INVALID_DATA, mem->current_file, mem->current_line_number, token);
-            token = strtok(NULL, "\t ,");
-            continue;
-        }
+    int i = index + 1;
+    char *token;
+
+    /* A long list of values may span several batches of tokens */
+    do {
+        for (; i < tokens->count; i++) {
+            token = token_text(tokens, i);
+            if (!validate_data(token)) {
+                add_error(mem->errors, ERR_INVALID_DATA, mem->current_file, mem->current_line_number, token);
+                continue;
+            }
 
-        value = atoi(token);
-        word = int_to_word(value);
-        write_to_memory(mem, mem->DC, word, false, NULL);
-        increment_DC(mem);
-        token = strtok(NULL, "\t ,");
-    }
+            value = atoi(token);
+            word = int_to_word(value);
+            write_to_memory(mem, word, false);
+            increment_DC(mem);
+        }
+        i = 0;
+    } while (lex_next_batch(tokens));
 }
 
 /**
  * @brief Parses a .string directive and stores its values in memory.
  *
- * @param current_token The current token being processed.
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the .string token.
  * @param mem Pointer to the Memory structure.
  */
-void handle_string_directive(const char *current_token, Memory *mem) {
+void handle_string_directive(const LineTokens *tokens, int index, Memory *mem) {
     char *str;
-    char *token = strtok(mem->current_line, "\t ,");
-    while (strcmp(token, current_token) != 0) {
-        token = strtok(NULL, "\t ,");
-    }
-    token = strtok(NULL, "\t ,");
-    if(!validate_string(token)){
-        add_error(ERR_INVALID_STRING, mem->current_file, mem->current_line_number, token);
+    char *token = token_text(tokens, index + 1);
+    if(token == NULL || !validate_string(token)){
+        add_error(mem->errors, ERR_INVALID_STRING, mem->current_file, mem->current_line_number, token ? token : "");
         return;
     }
     str = strchr(token, '"');
     if (str) {
         str++;  /* Skip the opening quote */
         while (*str && *str != '"') {
-            write_to_memory(mem, mem->DC, (Word) *str++, 0, NULL);
+            write_to_memory(mem, (Word) *str++, 0);
             increment_DC(mem);
         }
-        write_to_memory(mem, mem->DC, 0, 0, NULL);  /* Null terminator */
+        write_to_memory(mem, 0, 0);  /* Null terminator */
         increment_DC(mem);
     }
 }
 
 /**
- * @brief Determines if the current line contains an instruction.
+ * @brief Determines if the statement starting at a token is an instruction.
  *
- * @param mem Pointer to the Memory structure.
- * @return true if the current line is an instruction, false otherwise.
- */
-bool is_instruction(Memory *mem) {
-    char *current_line = str_duplicate(mem->current_line);
-    char *token = strtok(current_line, "\t ,");
-    while (token != NULL) {
-        if (strcmp(token, ".string") == 0 || strcmp(token, ".data") == 0 || strcmp(token, ".extern") == 0 ||
-            strcmp(token, ".entry") == 0) {
-            free(current_line);
-            return false;
-        } else if (strcmp(token, "mov") == 0 || strcmp(token, "cmp") == 0 || strcmp(token, "add") == 0 ||
-                   strcmp(token, "sub") == 0 || strcmp(token, "lea") == 0 || strcmp(token, "clr") == 0 ||
-                   strcmp(token, "not") == 0 || strcmp(token, "inc") == 0 || strcmp(token, "dec") == 0 ||
-                   strcmp(token, "jmp") == 0 || strcmp(token, "bne") == 0 || strcmp(token, "red") == 0 ||
-                   strcmp(token, "prn") == 0 || strcmp(token, "jsr") == 0 || strcmp(token, "rts") == 0 ||
-                   strcmp(token, "stop") == 0) {
-            free(current_line);
-            return true;
+ * The first token from the given index that is exactly a keyword decides: a mnemonic
+ * makes the statement an instruction, a directive does not.
+ *
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the first token of the statement.
+ * @return true if the statement is an instruction, false otherwise.
+ */
+static bool is_instruction(const LineTokens *tokens, int index) {
+    int i;
+    const Keyword *keyword;
+    for (i = index; i < tokens->count; i++) {
+        keyword = tokens->tokens[i].keyword;
+        if (keyword != NULL) {
+            return keyword->directive == DIRECTIVE_NONE;
         }
-        token = strtok(NULL, "\t ,:");
     }
-    free(current_line);
     return false;
 }
 
@@ -136,45 +130,103 @@ void handle_no_operand_instruction(char *line, Memory *mem) {
         fprintf(stderr, "Unknown instruction: %s\n", line);
     }
     instruction |= 0x4; /* Set ARE to 100 */
-    write_to_memory(mem, mem->IC, instruction, 1, NULL);
+    write_to_memory(mem, instruction, 1);
     increment_IC(mem);
 }
 
 /**
- * @brief Handles label declarations and stores them in the memory structure.
+ * @brief Interns the name of the file being parsed, so labels can refer to it by pointer.
  *
- * @param current_token The current token being processed.
+ * @param filename The name of the file.
  * @param mem Pointer to the Memory structure.
+ * @return The interned name, or NULL if memory allocation fails.
  */
-void handle_label(const char *current_token, Memory *mem) {
-    char *label_name;
-    char *current_line = str_duplicate(mem->current_line);
-    char *token = strtok(current_line, "\t ,");
-    Label *label;
-    bool instruction;
-    int address;
+static char* intern_file_name(const char *filename, Memory *mem) {
+    int symbol = intern_symbol(&mem->symbols, filename);
+    return (symbol == NO_SYMBOL) ? NULL : symbol_name(&mem->symbols, symbol);
+}
+
+/**
+ * @brief Encodes the word that refers to a label, from its address and kind.
+ *
+ * @param label The referenced label.
+ * @return The word holding the label's address and A/R/E bits.
+ */
+static Word label_word(const Label *label) {
+    Word word = 0;
 
-    while (strcmp(token, current_token) != 0) {
-        token = strtok(NULL, "\t ,");
+    if (label->external) {
+        word |= ARE_EXTERNAL; /* Set ARE to 001 */
+    } else if(label->entry){
+        word |= ARE_RELOCATABLE; /* Set ARE to 010 */
+    } else {
+        word |= ARE_ABSOLUTE; /* Set ARE to 100 */
     }
-    if(is_entry(mem)){ /* Skip entry labels */
-        free(current_line);
-        return;
+    word |= int_to_word(label->address) << 3;
+    return word;
+}
+
+/**
+ * @brief Patches every word on a label's fixup chain with the label's current word.
+ *
+ * @param label The label whose references are patched.
+ * @param mem Pointer to the Memory structure.
+ */
+static void patch_label_chain(const Label *label, Memory *mem) {
+    Word word = label_word(label);
+    int fixup;
+
+    for (fixup = label->fixup_chain; fixup >= 0; fixup = mem->fixups.fixups[fixup].next) {
+        mem->instructions.words[mem->fixups.fixups[fixup].word_index] = word;
     }
+}
 
-    if(is_extern(mem)){ /* Skip extern labels */
-        free(current_line);
-        return;
+/**
+ * @brief Checks whether a single-pass assembly already knows a label's final word.
+ *
+ * Instruction addresses are final once declared, since the code image comes first.
+ * Data addresses depend on the final Instruction Counter, so data labels wait for
+ * finish_single_pass.
+ *
+ * @param label The label.
+ * @param mem Pointer to the Memory structure.
+ * @return True if references to the label can be patched now, otherwise false.
+ */
+static bool is_label_final(const Label *label, const Memory *mem) {
+    return mem->single_pass && label->declared && label->is_instruction;
+}
+
+/**
+ * @brief Records a word that refers to a label, patching it at once when the label is final.
+ *
+ * @param word_index The index of the word in the instruction buffer.
+ * @param label The referenced label.
+ * @param mem Pointer to the Memory structure.
+ */
+static void add_reference(int word_index, Label *label, Memory *mem) {
+    add_fixup(mem, word_index, label);
+    if (is_label_final(label, mem)) {
+        mem->instructions.words[word_index] = label_word(label);
     }
-    label_name = str_duplicate(token);
-    label_name[strlen(label_name) - 1] = '\0';  /* Remove the colon */
-    if(!validate_label_declaration(label_name, mem)){
-        free(current_line);
+}
+
+/**
+ * @brief Declares a label at an address, unless it is already declared.
+ *
+ * In single-pass mode an instruction label gets its final address here, and the
+ * references made to it so far are patched.
+ *
+ * @param symbol The symbol ID of the label name.
+ * @param instruction Whether the label is associated with an instruction.
+ * @param address The address of the label.
+ * @param mem Pointer to the Memory structure.
+ */
+static void declare_label(int symbol, bool instruction, int address, Memory *mem) {
+    Label *label = find_symbol_label(&mem->labels, symbol);
+    if (label != NULL && label->declared) {
+        add_error(mem->errors, ERR_LABEL_ALREADY_DECLARED, mem->current_file, mem->current_line_number, label->name);
         return;
     }
-    label = find_label(mem->label_list, label_name);
-    instruction = is_instruction(mem);
-    address = instruction ? mem->IC : mem->DC;
     if (label != NULL) {
         label->is_instruction = instruction;
         label->address = address;
@@ -182,76 +234,161 @@ void handle_label(const char *current_token, Memory *mem) {
         label->file_name = mem->current_file;
         label->line_number = mem->current_line_number;
     } else {
-        add_label(&mem->label_list, label_name, address, instruction, false, false, mem->current_file, true, mem->current_line_number);
+        label = add_label(&mem->labels, symbol, address, instruction, false, false, mem->current_file, true, mem->current_line_number);
+    }
+    if (label != NULL && is_label_final(label, mem)) {
+        label->address += LOAD_ADDRESS;
+        patch_label_chain(label, mem);
+    }
+}
+
+/**
+ * @brief Marks a label as an entry, adding it if it has not been seen yet.
+ *
+ * @param symbol The symbol ID of the label name.
+ * @param mem Pointer to the Memory structure.
+ */
+static void mark_entry(int symbol, Memory *mem) {
+    Label *label = find_symbol_label(&mem->labels, symbol);
+    if (label != NULL) {
+        if(label->external || label->entry || (label->declared && label->file_name != mem->current_file)){
+            add_error(mem->errors, ERR_LABEL_ALREADY_DECLARED, mem->current_file, mem->current_line_number, label->name);
+        }
+        label->entry = true;
+        label->file_name = mem->current_file;
+        label->line_number = mem->current_line_number;
+        if (is_label_final(label, mem)) {
+            patch_label_chain(label, mem);  /* Entries are relocatable */
+        }
+    } else {
+        add_label(&mem->labels, symbol, 0, false, true, false, mem->current_file, false, mem->current_line_number);
     }
+}
 
-    free(label_name);
-    free(current_line);
+/**
+ * @brief Marks a label as external, adding it if it has not been seen yet.
+ *
+ * @param symbol The symbol ID of the label name.
+ * @param mem Pointer to the Memory structure.
+ */
+static void mark_extern(int symbol, Memory *mem) {
+    Label *label = find_symbol_label(&mem->labels, symbol);
+    if (label != NULL) {
+        if(label->declared || label->external || label->entry){
+            add_error(mem->errors, ERR_LABEL_ALREADY_DECLARED, mem->current_file, mem->current_line_number, label->name);
+        }
+        label->external = true;
+        label->file_name = mem->current_file;
+        label->line_number = mem->current_line_number;
+    } else {
+        add_label(&mem->labels, symbol, 0, false, false, true, mem->current_file, false, mem->current_line_number);
+    }
 }
 
 /**
- * @brief Checks if the current line is an .entry directive.
+ * @brief Looks up a label used as an operand, adding it as undeclared if it has not been seen yet.
  *
+ * @param symbol The symbol ID of the label name.
  * @param mem Pointer to the Memory structure.
- * @return true if the current line is an .entry directive, false otherwise.
- */
-bool is_entry(Memory *mem) {
-    char *current_line = str_duplicate(mem->current_line);
-    char *token = strtok(current_line, "\t ,");
-    while (token != NULL) {
-        if (strcmp(token, ".entry") == 0) {
-            free(current_line);
+ * @return The label, or NULL if memory allocation fails.
+ */
+static Label* reference_label(int symbol, Memory *mem) {
+    Label *label = find_symbol_label(&mem->labels, symbol);
+    if (label != NULL) {
+        label->line_number = mem->current_line_number;
+        return label;
+    }
+    return add_label(&mem->labels, symbol, 0, false, false, false, mem->current_file, false, mem->current_line_number);
+}
+
+/**
+ * @brief Handles label declarations and stores them in the memory structure.
+ *
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the label token.
+ * @param mem Pointer to the Memory structure.
+ */
+void handle_label(const LineTokens *tokens, int index, Memory *mem) {
+    char *label_name;
+    bool instruction;
+    int address;
+    int symbol;
+
+    if(is_entry(tokens, index)){ /* Skip entry labels */
+        return;
+    }
+
+    if(is_extern(tokens, index)){ /* Skip extern labels */
+        return;
+    }
+    label_name = token_text(tokens, index);
+    label_name[tokens->tokens[index].length - 1] = '\0';  /* Remove the colon */
+    if(!validate_label_name(label_name, mem)){
+        return;
+    }
+    symbol = intern_symbol(&mem->symbols, label_name);
+    if (symbol == NO_SYMBOL) {
+        return;
+    }
+    instruction = is_instruction(tokens, index + 1);
+    address = instruction ? mem->IC : mem->DC;
+    if (mem->isolated) {
+        add_label_event(mem, LABEL_DECLARED, symbol, address, instruction, -1);
+    } else {
+        declare_label(symbol, instruction, address, mem);
+    }
+}
+
+/**
+ * @brief Checks if the statement starting at a token is an .entry directive.
+ *
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the first token of the statement.
+ * @return true if the statement contains an .entry directive, false otherwise.
+ */
+bool is_entry(const LineTokens *tokens, int index) {
+    int i;
+    for (i = index; i < tokens->count; i++) {
+        if (tokens->tokens[i].keyword != NULL && tokens->tokens[i].keyword->directive == DIRECTIVE_ENTRY) {
             return true;
         }
-        token = strtok(NULL, "\t ,:");
     }
-    free(current_line);
     return false;
 }
 
 /**
- * @brief Checks if the current line is an .extern directive.
+ * @brief Checks if the statement starting at a token is an .extern directive.
  *
- * @param mem Pointer to the Memory structure.
- * @return true if the current line is an .extern directive, false otherwise.
- */
-bool is_extern(Memory *mem) {
-    char *current_line = str_duplicate(mem->current_line);
-    char *token = strtok(current_line, "\t ,");
-    while (token != NULL) {
-        if (strcmp(token, ".extern") == 0) {
-            free(current_line);
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the first token of the statement.
+ * @return true if the statement contains an .extern directive, false otherwise.
+ */
+bool is_extern(const LineTokens *tokens, int index) {
+    int i;
+    for (i = index; i < tokens->count; i++) {
+        if (tokens->tokens[i].keyword != NULL && tokens->tokens[i].keyword->directive == DIRECTIVE_EXTERN) {
             return true;
         }
-        token = strtok(NULL, "\t ,:");
     }
-    free(current_line);
     return false;
 }
 
 /**
  * @brief Parses a generic instruction with operands.
  *
- * @param current_token The current token being processed.
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the operation token.
  * @param mem Pointer to the Memory structure.
  */
-void handle_instruction(const char *current_token, Memory *mem) {
+void handle_instruction(const LineTokens *tokens, int index, Memory *mem) {
     Word instruction;
     bool is_valid = true;
     int opcode, source_mode = UNDEFINED_MODE, dest_mode = UNDEFINED_MODE;
-    char *line = str_duplicate(mem->current_line);
-    char *operation, *operand1, *operand2;
-
-    char *token = strtok(line, "\t ,");
-    while (strcmp(token, current_token) != 0) {
-        token = strtok(NULL, "\t ,");
-    }
+    const Keyword *keyword = tokens->tokens[index].keyword;
+    char *operand1 = token_text(tokens, index + 1);   /* Get the first operand */
+    char *operand2 = token_text(tokens, index + 2);   /* Get the second operand if exists */
 
-    operation = str_duplicate(token);  /* Get the operation (opcode) */
-    operand1 = strtok(NULL, ", \t"); /* Get the first operand */
-    operand2 = strtok(NULL, ", \t"); /* Get the second operand if exists */
-
-    opcode = get_opcode(operation);
+    opcode = (keyword != NULL) ? keyword->opcode : INVALID_OPCODE;
 
     if (operand1) {
         is_valid = validate_operand(operand1, mem);
@@ -266,14 +403,10 @@ void handle_instruction(const char *current_token, Memory *mem) {
     }
 
     if(is_valid == false){
-        free(line);
-        free(operation);
         return;
     }
 
-    if(!validate_instruction(operation, dest_mode, source_mode, mem)){
-        free(line);
-        free(operation);
+    if(!validate_instruction(keyword, dest_mode, source_mode, mem)){
         return;
     }
 
@@ -284,7 +417,7 @@ void handle_instruction(const char *current_token, Memory *mem) {
     instruction = (opcode << 11) | (source_mode << 7) | (dest_mode << 3) | ARE_ABSOLUTE; /* ARE is 100 */
 
     /* Write the instruction to memory */
-    write_to_memory(mem, mem->IC, instruction, true, NULL);
+    write_to_memory(mem, instruction, true);
     increment_IC(mem);
 
     /* Handle any additional words for operands (e.g., direct addresses) */
@@ -299,9 +432,6 @@ void handle_instruction(const char *current_token, Memory *mem) {
     } else if (operand1 != NULL) {
         handle_operand(operand1, dest_mode, mem);
     }
-
-    free(operation);
-    free(line);
 }
 
 /**
@@ -346,7 +476,7 @@ void handle_double_register_operands(char *operand1, char *operand2, int dest_mo
         additional_word |= (Word) (operand2[1] - '0') << 6; /* Extract destination register number */
     }
     additional_word |= ARE_ABSOLUTE; /* set ARE is 100 */
-    write_to_memory(mem, mem->IC, additional_word, true, NULL);
+    write_to_memory(mem, additional_word, true);
     increment_IC(mem);
 }
 
@@ -359,13 +489,14 @@ void handle_double_register_operands(char *operand1, char *operand2, int dest_mo
  */
 void handle_operand(char *operand, int address_mode, Memory *mem) {
     Word additional_word = 0;
-    Label *label = NULL;
-    char *label_name = NULL;
+    Label *fixup_label = NULL;
+    int symbol = NO_SYMBOL;
+    bool written;
 
     switch (address_mode) {
         case IMMEDIATE_MODE:  /* Immediate addressing */
             if(!validate_data(operand)){
-                add_error(ERR_INVALID_DATA, mem->current_file, mem->current_line_number, operand);
+                add_error(mem->errors, ERR_INVALID_DATA, mem->current_file, mem->current_line_number, operand);
                 return;
             }
             if (operand[0] == '#') { /* Skip the '#' character */
@@ -377,25 +508,10 @@ void handle_operand(char *operand, int address_mode, Memory *mem) {
             break;
 
         case DIRECT_MODE:  /* Direct addressing */
-            /* Assume the operand is a label, and resolve its address */
-            if (is_label(operand, mem->label_list)) {
-                label = find_label(mem->label_list, operand);
-                additional_word = label->address;
-                label_name = str_duplicate(label->name);
-                label->line_number = mem->current_line_number;
-            } else {
-                add_label(&mem->label_list, operand, 0, false, false, false, mem->current_file, false, mem->current_line_number);
-            }
-            additional_word <<= 3;
-            if (label != NULL) {
-                if (label->external) {
-                    additional_word |= (ARE_EXTERNAL);  /* Set ARE to 001 if external */
-                } else {
-                    additional_word |= (ARE_RELOCATABLE);  /* Set ARE to 010 */
-                }
-            } else {
-                label_name = str_duplicate(operand);
-                additional_word |= (ARE_EXTERNAL);  /* Set ARE to 001 */
+            /* Assume the operand is a label; the word is filled in by resolve_fixups */
+            symbol = intern_symbol(&mem->symbols, operand);
+            if (symbol != NO_SYMBOL && !mem->isolated) {
+                fixup_label = reference_label(symbol, mem);
             }
             break;
 
@@ -414,211 +530,385 @@ void handle_operand(char *operand, int address_mode, Memory *mem) {
             break;
 
         default:
-            add_error(ERR_INVALID_ADDRESS_MODE, mem->current_file, mem->current_line_number, mem->current_line);
+            add_error(mem->errors, ERR_INVALID_ADDRESS_MODE, mem->current_file, mem->current_line_number, mem->current_line);
             return;
     }
 
-    /* Write the additional word to memory */
-    write_to_memory(mem, mem->IC, additional_word, true, label_name);
-    increment_IC(mem);
-
-    if (label_name != NULL) {
-        free(label_name);
+    /* Write the additional word to memory, recording where a label's final address goes */
+    written = write_to_memory(mem, additional_word, true);
+    if (symbol != NO_SYMBOL && mem->isolated) {
+        add_label_event(mem, LABEL_REFERENCED, symbol, 0, false, written ? mem->instructions.count - 1 : -1);
+    } else if (written && fixup_label != NULL) {
+        add_reference(mem->instructions.count - 1, fixup_label, mem);
     }
+    increment_IC(mem);
 }
 
 /**
  * @brief Parses an .entry directive and updates the corresponding label.
  *
- * @param current_token The current token being processed.
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the directive token.
  * @param mem Pointer to the Memory structure.
  */
-void handle_entry(const char *current_token, Memory *mem) {
-    Label *label = NULL;
-    char *token = strtok(mem->current_line, "\t ,");
-    while (strcmp(token, current_token) != 0) {
-        token = strtok(NULL, "\t ,");
+void handle_entry(const LineTokens *tokens, int index, Memory *mem) {
+    char *token = token_text(tokens, index + 1);
+    int symbol;
+    if(token == NULL){
+        add_error(mem->errors, ERR_INVALID_LABEL_NAME, mem->current_file, mem->current_line_number, "");
+        return;
     }
-    token = strtok(NULL, "\t ,");
     if(validate_label_name(token, mem) == false){
         return;
     }
-    label = find_label(mem->label_list, token);
-    if (label != NULL) {
-        if(label->external || label->entry || (label->declared && strcmp(label->file_name, mem->current_file) != 0)){
-            add_error(ERR_LABEL_ALREADY_DECLARED, mem->current_file, mem->current_line_number, token);
-        }
-        label->entry = true;
-        label->file_name = mem->current_file;
-        label->line_number = mem->current_line_number;
+    symbol = intern_symbol(&mem->symbols, token);
+    if (symbol == NO_SYMBOL) {
+        return;
+    }
+    if (mem->isolated) {
+        add_label_event(mem, LABEL_ENTRY, symbol, 0, false, -1);
     } else {
-        add_label(&mem->label_list, token, 0, false, true, false, mem->current_file, false, mem->current_line_number);
+        mark_entry(symbol, mem);
     }
 }
 
 /**
  * @brief Parses an .extern directive and updates the corresponding label.
  *
- * @param current_token The current token being processed.
+ * @param tokens Pointer to the tokens of the current line.
+ * @param index The index of the directive token.
  * @param mem Pointer to the Memory structure.
  */
-void handle_extern(const char *current_token, Memory *mem){
-    Label *label = NULL;
-    char *token = strtok(mem->current_line, "\t ,");
-    while (strcmp(token, current_token) != 0) {
-        token = strtok(NULL, "\t ,");
+void handle_extern(const LineTokens *tokens, int index, Memory *mem){
+    char *token = token_text(tokens, index + 1);
+    int symbol;
+    if(token == NULL){
+        add_error(mem->errors, ERR_INVALID_LABEL_NAME, mem->current_file, mem->current_line_number, "");
+        return;
     }
-    token = strtok(NULL, "\t ,");
     if(validate_label_name(token, mem) == false){
         return;
     }
-    label = find_label(mem->label_list, token);
-    if (label != NULL) {
-        if(label->declared || label->external || label->entry){
-            add_error(ERR_LABEL_ALREADY_DECLARED, mem->current_file, mem->current_line_number, token);
-        }
-        label->external = true;
-        label->file_name = mem->current_file;
-        label->line_number = mem->current_line_number;
+    symbol = intern_symbol(&mem->symbols, token);
+    if (symbol == NO_SYMBOL) {
+        return;
+    }
+    if (mem->isolated) {
+        add_label_event(mem, LABEL_EXTERN, symbol, 0, false, -1);
     } else {
-        add_label(&mem->label_list, token, 0, false, false, true, mem->current_file, false, mem->current_line_number);
+        mark_extern(symbol, mem);
     }
 }
 
 /**
  * @brief Parses a line of assembly code.
  *
+ * The line is tokenized once; any labels are handled first, and the token that follows
+ * them selects the handler for the rest of the statement.
+ *
  * @param line The line of assembly code to parse.
+ * @param tokens Pointer to the LineTokens reused to tokenize the line.
  * @param mem Pointer to the Memory structure.
  */
-void parse_line(char *line, Memory *mem) {
-    char *line_copy = str_duplicate(line);
-    char *token = strtok(line, " \t\n");
-    char *current_token;
-
-    write_current_line(mem, line_copy);
+void parse_line(const char *line, LineTokens *tokens, Memory *mem) {
+    int i;
+    char *token;
+    const char *colon;
+
+    mem->current_line = line;
+    if (!lex_line(tokens, line)) {
+        add_error(mem->errors, ERR_MEMORY_ALLOCATION_FAILED, mem->current_file, mem->current_line_number, NULL);
+        return;
+    }
 
     /* TODO: Validate memory */
 
-    while (token != NULL) {
-        if (token[0] == ';') {
-            break; /* Skip comments */
-        } else if (token[0] == '\0') {
-            break;
-        } else if (strchr(token, ':') != NULL) {
-            handle_label(token, mem);
-            move_to_next_word(mem);
-        } else if (strstr(token, ".data") != NULL) {
-            handle_data_directive(token, mem);
-            break;
-        } else if (strstr(token, ".string") != NULL) {
-            handle_string_directive(token, mem);
-            break;
-        } else if (strstr(token, ".entry")) {
-            handle_entry(token, mem);
-            break;
-        } else if (strstr(token, ".extern")) {
-            handle_extern(token, mem);
-            break;
-        } else if (strstr(token, "stop") != NULL || strstr(token, "rts") != NULL) {
-            handle_no_operand_instruction(token, mem);
-            break;
-        } else if (is_instruction(mem)) {
-            handle_instruction(token, mem);
-            break;
-        } else {
-            add_error(ERR_UNEXPECTED_TOKEN, mem->current_file, mem->current_line_number, token);
-            break;
-        }
+    for (i = 0; i < tokens->count; i++) {
+        token = token_text(tokens, i);
+        switch (tokens->tokens[i].kind) {
+            case TOKEN_COMMENT:
+                return; /* Skip comments */
+
+            case TOKEN_LABEL:
+                handle_label(tokens, i, mem);
+                /* Move the current line past the label */
+                colon = strchr(mem->current_line, ':');
+                if (colon != NULL) {
+                    mem->current_line = colon + 1;
+                }
+                while (*mem->current_line == ' ' || *mem->current_line == '\t') {
+                    mem->current_line++;
+                }
+                continue;
+
+            case TOKEN_DATA:
+                handle_data_directive(tokens, i, mem);
+                return;
+
+            case TOKEN_STRING:
+                handle_string_directive(tokens, i, mem);
+                return;
 
-        /* Reset token & Move to the next one */
-        current_token = token;
-        token = strtok(line_copy, " \t\n");
+            case TOKEN_ENTRY:
+                handle_entry(tokens, i, mem);
+                return;
+
+            case TOKEN_EXTERN:
+                handle_extern(tokens, i, mem);
+                return;
+
+            case TOKEN_NO_OPERAND_INSTRUCTION:
+                handle_no_operand_instruction(token, mem);
+                return;
 
-        while (strcmp(token, current_token) != 0) {
-            token = strtok(NULL, " \t\n");
+            default:
+                if (is_instruction(tokens, i)) {
+                    handle_instruction(tokens, i, mem);
+                } else {
+                    add_error(mem->errors, ERR_UNEXPECTED_TOKEN, mem->current_file, mem->current_line_number, token);
+                }
+                return;
         }
-        token = strtok(NULL, " \t\n");
     }
-    free(line_copy);
 }
 
 /**
- * @brief Parses the given assembly file and processes its contents.
+ * @brief Parses the preprocessed lines held by a context and processes their contents.
  *
- * @param filename The name of the file to parse.
+ * @param context Pointer to the Context holding the preprocessed lines of one file.
  * @param mem Pointer to the Memory structure.
  */
-void parse_file(const char *filename, Memory *mem) {
-    FILE *input;
-    char *line;
+void parse_context(Context *context, Memory *mem) {
+    int i;
+    LineTokens tokens;
+
+    init_line_tokens(&tokens);
     mem->current_line_number = 0;
-    mem->current_file = str_duplicate(filename);
-    input = fopen(filename, "r");
-    if (!input) {
-        add_error(ERR_FILE_NOT_FOUND, filename, 0, NULL);
+    mem->current_file = intern_file_name(context->filename, mem);
+
+    /* Lines past the error limit could only add errors that are dropped */
+    for (i = 0; i < context->line_count && !error_limit_reached(mem->errors); i++) {
+        mem->current_line_number++;
+        if(context->preprocessed_lines[i][0] != NULL_TERMINATOR){
+            parse_line(context->preprocessed_lines[i], &tokens, mem);
+        }
+    }
+
+    mem->current_line = NULL;
+    free_line_tokens(&tokens);
+}
+
+/**
+ * @brief Limits an address to the end of memory, where the counters stop.
+ *
+ * @param address The address to limit.
+ * @return The address, or MEMORY_SIZE if it is past the end of memory.
+ */
+static int cap_address(int address) {
+    return (address < MEMORY_SIZE) ? address : MEMORY_SIZE;
+}
+
+/**
+ * @brief Initializes a section for parsing one file apart from the others.
+ *
+ * @param section Pointer to the Section to initialize.
+ * @param macros The macros of the assembly, which label names must not reuse.
+ */
+void init_section(Section *section, const struct MacroTable *macros) {
+    initialize_memory(&section->memory);
+    init_error_handling(&section->errors);
+    section->memory.DC = 0;
+    section->memory.macros = macros;
+    section->memory.errors = &section->errors;
+    section->memory.isolated = true;
+}
+
+/**
+ * @brief Runs the first pass over one file into its own section.
+ *
+ * Only the section is touched, so the sections of different files can be parsed on
+ * different threads at the same time.
+ *
+ * @param context Pointer to the Context holding the preprocessed lines of the file.
+ * @param section Pointer to the Section of the file.
+ */
+void parse_section(Context *context, Section *section) {
+    parse_context(context, &section->memory);
+}
+
+/**
+ * @brief Joins the section of the next file onto the memory of the assembly.
+ *
+ * The words are moved to follow those of the earlier files, and the logged label
+ * operations are replayed on the shared label table in their original order, with the
+ * errors of the file reported between them where they were found. Addresses past the
+ * end of memory stick at MEMORY_SIZE as the counters do, and the overflow messages are
+ * printed in their original order. This leaves the memory, labels and errors exactly
+ * as parsing the file in place would have.
+ *
+ * @param context Pointer to the Context holding the preprocessed lines of the file.
+ * @param section Pointer to the parsed Section of the file.
+ * @param mem Pointer to the Memory structure of the assembly.
+ */
+void join_section(Context *context, const Section *section, Memory *mem) {
+    const Memory *part = &section->memory;
+    const LabelEvent *event;
+    Label *label;
+    int *symbols;
+    int symbol;
+    int IC = mem->IC;
+    int DC = mem->DC;
+    int first_word = mem->instructions.count;
+    int reported = 0;
+    int address;
+    int i;
+
+    if (IC + part->IC > MEMORY_SIZE || DC + part->DC > MEMORY_SIZE) {
+        report_counter_overflows(mem, part, IC, DC);
+    }
+
+    /* Intern each name of the file once, so replaying its events is pure indexing */
+    symbols = (int *)counted_malloc((part->symbols.count + 1) * sizeof(int));
+    if (symbols == NULL) {
+        fprintf(stderr, "Memory allocation error in join_section\n");
         return;
     }
+    for (i = 0; i < part->symbols.count; i++) {
+        symbols[i] = intern_symbol(&mem->symbols, symbol_name(&part->symbols, i));
+    }
 
-    while ((line = read_line(input)) != NULL) {
-        mem->current_line_number++;
-        if(strcmp(line, "") != 0){
-            parse_line(line, mem);
+    mem->current_file = intern_file_name(context->filename, mem);
+    for (i = 0; i < part->instructions.count; i++) {
+        write_to_memory(mem, part->instructions.words[i], true);
+    }
+    for (i = 0; i < part->data.count; i++) {
+        write_to_memory(mem, part->data.words[i], false);
+    }
+
+    for (i = 0; i < part->label_log.count; i++) {
+        event = &part->label_log.events[i];
+        append_error_range(mem->errors, &section->errors, reported, event->error_count - reported);
+        reported = event->error_count;
+        mem->current_line_number = event->line_number;
+        symbol = symbols[event->symbol];
+        if (symbol == NO_SYMBOL) {
+            continue;
+        }
+
+        switch (event->kind) {
+            case LABEL_DECLARED:
+                address = event->address + (event->is_instruction ? IC : DC);
+                declare_label(symbol, event->is_instruction, cap_address(address), mem);
+                break;
+
+            case LABEL_ENTRY:
+                mark_entry(symbol, mem);
+                break;
+
+            case LABEL_EXTERN:
+                mark_extern(symbol, mem);
+                break;
+
+            case LABEL_REFERENCED:
+                label = reference_label(symbol, mem);
+                if (label != NULL && event->word_index >= 0 && first_word + event->word_index < mem->instructions.count) {
+                    add_reference(first_word + event->word_index, label, mem);
+                }
+                break;
         }
-        free(line);
     }
+    append_error_range(mem->errors, &section->errors, reported, section->errors.count - reported);
+    free(symbols);
 
-    fclose(input);
+    mem->IC = cap_address(IC + part->IC);
+    mem->DC = cap_address(DC + part->DC);
+    mem->current_line_number = part->current_line_number;
 }
 
 /**
- * @brief Resolves labels and updates memory with final addresses.
+ * @brief Frees the words, labels and errors held by a section.
+ *
+ * @param section Pointer to the Section to free.
+ */
+void free_section(Section *section) {
+    clear_memory(&section->memory);
+    free_errors(&section->errors);
+}
+
+/**
+ * @brief Patches every word that refers to a label with the label's final address.
+ *
+ * Runs once after the first pass over all files, walking only the fixups recorded
+ * for label operands rather than every instruction word.
  *
- * @param filename The name of the file being processed.
  * @param mem Pointer to the Memory structure.
  */
-void second_parse(const char *filename, Memory *mem) {
+void resolve_fixups(Memory *mem) {
+    const Fixup *fixup;
+    int i;
+
+    for (i = 0; i < mem->fixups.count; i++) {
+        fixup = &mem->fixups.fixups[i];
+        mem->instructions.words[fixup->word_index] = label_word(fixup->label);
+    }
+}
+
+/**
+ * @brief Completes a single-pass assembly once every file has been parsed.
+ *
+ * Instruction labels were given their final addresses, and their references patched,
+ * as they were declared. This gives the data labels theirs and patches the chains of
+ * the labels that were never declared, which are externs or errors. It is the only
+ * walk after the first pass when every label checks out.
+ *
+ * @param mem Pointer to the Memory structure.
+ * @return True if some label is undeclared or both external and an entry, so the
+ *         files must still be checked with second_parse to report it.
+ */
+bool finish_single_pass(Memory *mem) {
     Label *label;
-    ListNode *node;
-    Word word = 0;
+    bool unresolved = false;
 
-    for (node = mem->instructionList; node != NULL; node = node->next) {
-        if (node->label_name != NULL) {
-            word = 0;
-            if (is_label(node->label_name, mem->label_list)) {
-                label = find_label(mem->label_list, node->label_name);
-                if (label->external) {
-                    word |= ARE_EXTERNAL; /* Set ARE to 001 */
-                } else if(label->entry){
-                    word |= ARE_RELOCATABLE; /* Set ARE to 010 */
-                } else {
-                    word |= ARE_ABSOLUTE; /* Set ARE to 100 */
-                }
-                word |= int_to_word(label->address) << 3;
-                node->data = word;
-            } else {
-                word |= ARE_EXTERNAL; /* Set ARE to 001 */
-                node->data = word;
-            }
+    for (label = mem->labels.head; label != NULL; label = label->next) {
+        if (!label->is_instruction) {
+            label->address = (label->address == 0) ? 0 : (label->address + mem->IC);
+            patch_label_chain(label, mem);
+        }
+        if (!label->declared || (label->external && label->entry)) {
+            unresolved = true;
         }
     }
-    for (label = mem->label_list; label != NULL; label = label->next) {
+    return unresolved;
+}
+
+/**
+ * @brief Reports the label errors that belong to one file after the first pass.
+ *
+ * @param filename The name of the file being processed.
+ * @param mem Pointer to the Memory structure.
+ */
+void second_parse(const char *filename, Memory *mem) {
+    Label *label;
+    int symbol = find_symbol(&mem->symbols, filename);
+    const char *file = (symbol == NO_SYMBOL) ? NULL : symbol_name(&mem->symbols, symbol);
+
+    for (label = mem->labels.head; label != NULL; label = label->next) {
         if (label->external){
-            if(!label->declared && strcmp(label->file_name, filename) == 0){
-                add_error(ERR_LABEL_NOT_DECLARED, label->file_name, label->line_number, label->name);
+            if(!label->declared && label->file_name == file){
+                add_error(mem->errors, ERR_LABEL_NOT_DECLARED, label->file_name, label->line_number, label->name);
             }
             if (label->entry) {
-                add_error(ERR_LABEL_DECLARED_AS_EXTERNAL, label->file_name, label->line_number, label->name);
+                add_error(mem->errors, ERR_LABEL_DECLARED_AS_EXTERNAL, label->file_name, label->line_number, label->name);
             }
         } else if (label->entry) {
             if(label->external){
-                add_error(ERR_ENTRY_LABEL_EXTERNAL, label->file_name, label->line_number, label->name);
+                add_error(mem->errors, ERR_ENTRY_LABEL_EXTERNAL, label->file_name, label->line_number, label->name);
             }
-            if (!label->declared && strcmp(label->file_name, filename) == 0) {
-                add_error(ERR_LABEL_NOT_DECLARED, label->file_name, label->line_number, label->name);
+            if (!label->declared && label->file_name == file) {
+                add_error(mem->errors, ERR_LABEL_NOT_DECLARED, label->file_name, label->line_number, label->name);
             }
-        } else if (!label->declared && strcmp(label->file_name, filename) == 0) {
-            add_error(ERR_LABEL_NOT_DECLARED, label->file_name, label->line_number, label->name);
+        } else if (!label->declared && label->file_name == file) {
+            add_error(mem->errors, ERR_LABEL_NOT_DECLARED, label->file_name, label->line_number, label->name);
         }
     }
 }
@@ -0,0 +1,121 @@
+/**
+ * @file pool.c
+ * @brief Implements the worker thread pool used for the parallel stages.
+ */
+
+#define _POSIX_C_SOURCE 199506L  /* pthreads */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "pool.h"
+#include "stats.h"
+
+/**
+ * @brief Shared state of one run_in_parallel call.
+ */
+typedef struct Pool {
+    pthread_mutex_t lock;     /**< Guards next_task */
+    int next_task;            /**< Number of the next unclaimed task */
+    int task_count;           /**< Number of tasks */
+    PoolTask task;            /**< The function that runs one task */
+    void *data;               /**< Pointer passed to every task */
+} Pool;
+
+/**
+ * @brief A thread started by run_in_parallel.
+ */
+typedef struct Worker {
+    pthread_t thread;         /**< The thread */
+    Pool *pool;               /**< The pool the thread takes tasks from */
+    Stats stats;              /**< Counters of the thread, merged into the caller's once it is joined */
+} Worker;
+
+/**
+ * @brief Claims and runs tasks until none are left.
+ *
+ * @param arg Pointer to the Pool.
+ * @return Always NULL.
+ */
+static void* work(void *arg) {
+    Pool *pool = (Pool *)arg;
+    int index;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        index = pool->next_task++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (index >= pool->task_count) {
+            return NULL;
+        }
+        pool->task(index, pool->data);
+    }
+}
+
+/**
+ * @brief Runs a started thread: attaches its own Stats and works on the pool.
+ *
+ * @param arg Pointer to the Worker.
+ * @return Always NULL.
+ */
+static void* run_worker(void *arg) {
+    Worker *worker = (Worker *)arg;
+
+    attach_stats(&worker->stats);
+    return work(worker->pool);
+}
+
+/**
+ * @brief Runs a numbered set of tasks on a pool of threads and waits for all of them.
+ *
+ * @param task_count The number of tasks to run.
+ * @param thread_count The maximum number of threads to use, including the calling thread.
+ * @param task The function that runs one task.
+ * @param data Pointer passed to every task.
+ */
+void run_in_parallel(int task_count, int thread_count, PoolTask task, void *data) {
+    Pool pool;
+    Worker *workers = NULL;
+    Stats *stats = thread_stats();
+    int started = 0;
+    int i;
+
+    if (thread_count > task_count) {
+        thread_count = task_count;
+    }
+
+    pool.next_task = 0;
+    pool.task_count = task_count;
+    pool.task = task;
+    pool.data = data;
+
+    if (thread_count <= 1 || pthread_mutex_init(&pool.lock, NULL) != 0) {
+        for (i = 0; i < task_count; i++) {
+            task(i, data);
+        }
+        return;
+    }
+
+    workers = (Worker *)counted_malloc((thread_count - 1) * sizeof(Worker));
+    if (workers != NULL) {
+        while (started < thread_count - 1) {
+            workers[started].pool = &pool;
+            init_stats(&workers[started].stats);
+            if (pthread_create(&workers[started].thread, NULL, run_worker, &workers[started]) != 0) {
+                break;
+            }
+            started++;
+        }
+    }
+
+    work(&pool);
+
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        if (stats != NULL) {
+            merge_stats(stats, &workers[i].stats);
+        }
+    }
+    free(workers);
+    pthread_mutex_destroy(&pool.lock);
+}
@@ -2,52 +2,162 @@
  * @file preprocessor.c
  * @brief Handles macro expansion and prepares the source code for parsing.
  *
- * This module reads the input file, processes macros, and writes the expanded code
- * to a temporary file. It manages the lifecycle of macros and ensures that the code
- * is properly expanded before being passed on to the parser.
+ * This module reads the input file once, records macro definitions and expands macro
+ * uses as it goes, and collects the expanded code in the file's context. Macros are
+ * kept in a hash table owned by the caller, so they can be looked up by name in
+ * constant time during preprocessing and label validation.
  */
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 #include "preprocessor.h"
+#include "assembler.h"
 #include "validations.h"
 #include "error.h"
+#include "operations.h"
+#include "stats.h"
 
 #define INITIAL_LINE_CAPACITY 100
+#define TOKEN_SEPARATORS " \t\n"
 
-static Macro *macro_list = NULL;
-static bool macros_present = false;
+#define INITIAL_MACRO_CAPACITY 64
+#define INITIAL_DEFERRED_CAPACITY 16
 
 /**
- * @brief Adds a new macro to the macro list.
+ * @brief Finds the slot holding the macro with the given name, or the empty slot where it belongs.
  *
- * This function adds a macro to the head of the macro list. The list is used to store
- * all macros defined during the preprocessing stage.
+ * @param table The macro table, which must have at least one slot.
+ * @param name The macro name to look up.
+ * @param hash The hash of the name.
+ * @return A pointer to the matching or empty slot.
+ */
+static Macro** find_macro_slot(const MacroTable *table, const char *name, unsigned long hash) {
+    unsigned long mask = (unsigned long) table->capacity - 1;
+    unsigned long index = hash & mask;
+    Macro **slot = &table->slots[index];
+
+    while (*slot != NULL) {
+        if ((*slot)->hash == hash && strcmp((*slot)->name, name) == 0) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+        slot = &table->slots[index];
+    }
+    return slot;
+}
+
+/**
+ * @brief Doubles the number of slots in the table and re-inserts the visible macros.
+ *
+ * @param table The macro table to grow.
+ * @return True if the table was grown successfully, otherwise false.
+ */
+static bool grow_macro_table(MacroTable *table) {
+    int capacity = (table->capacity == 0) ? INITIAL_MACRO_CAPACITY : table->capacity * 2;
+    unsigned long mask = (unsigned long) capacity - 1;
+    unsigned long index;
+    Macro **slots = (Macro **)counted_calloc(capacity, sizeof(Macro *));
+    int i;
+
+    if (slots == NULL) {
+        return false;
+    }
+
+    for (i = 0; i < table->capacity; i++) {
+        if (table->slots[i] != NULL) {
+            index = table->slots[i]->hash & mask;
+            while (slots[index] != NULL) {
+                index = (index + 1) & mask;
+            }
+            slots[index] = table->slots[i];
+        }
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Initializes an empty macro table.
+ *
+ * @param table Pointer to the MacroTable to initialize.
+ */
+void init_macro_table(MacroTable *table) {
+    table->slots = NULL;
+    table->capacity = 0;
+    table->count = 0;
+    table->head = NULL;
+}
+
+/**
+ * @brief Adds a new macro to the macro table.
+ *
+ * A macro with the same name as an earlier one replaces it for later lookups. Every
+ * macro stays chained from the table's head so it can be freed.
  *
+ * @param table Pointer to the macro table.
  * @param new_macro Pointer to the macro to be added.
+ * @return True if the macro was added, false if memory allocation failed.
  */
-void add_macro(Macro *new_macro) {
-    new_macro->next = macro_list;
-    macro_list = new_macro;
-    macros_present = true;
+bool add_macro(MacroTable *table, Macro *new_macro) {
+    Macro **slot;
+
+    /* Keep the load factor at or below one half */
+    if ((table->count + 1) * 2 > table->capacity && !grow_macro_table(table)) {
+        return false;
+    }
+
+    new_macro->hash = hash_string(new_macro->name);
+    slot = find_macro_slot(table, new_macro->name, new_macro->hash);
+    if (*slot == NULL) {
+        table->count++;
+    }
+    *slot = new_macro;
+
+    new_macro->next = table->head;
+    table->head = new_macro;
+    return true;
 }
 
 /**
- * @brief Finds a macro by its name.
+ * @brief Finds a macro by its name with a single hash probe sequence.
  *
- * Searches the macro list for a macro with the specified name. If found, it returns
- * a pointer to the macro; otherwise, it returns NULL.
+ * @param table The macro table.
+ * @param name The name of the macro to find.
+ * @return Pointer to the macro if found, or NULL if not found.
+ */
+Macro* find_macro(const MacroTable *table, const char *name) {
+    if (table->count == 0) {
+        return NULL;
+    }
+    return *find_macro_slot(table, name, hash_string(name));
+}
+
+/**
+ * @brief Finds a macro by a name that is not null-terminated and whose hash is known.
  *
+ * @param table The macro table.
  * @param name The name of the macro to find.
+ * @param length The length of the name.
+ * @param hash The hash of the name.
  * @return Pointer to the macro if found, or NULL if not found.
  */
-Macro* find_macro(const char *name) {
-    Macro *current = macro_list;
-    while (current != NULL) {
-        if (strcmp(current->name, name) == 0) {
-            return current;
+static Macro* find_macro_span(const MacroTable *table, const char *name, size_t length, unsigned long hash) {
+    unsigned long mask = (unsigned long) table->capacity - 1;
+    unsigned long index = hash & mask;
+    Macro *macro;
+
+    if (table->count == 0) {
+        return NULL;
+    }
+    while ((macro = table->slots[index]) != NULL) {
+        if (macro->hash == hash && strncmp(macro->name, name, length) == 0 && macro->name[length] == NULL_TERMINATOR) {
+            return macro;
         }
-        current = current->next;
+        index = (index + 1) & mask;
     }
     return NULL;
 }
@@ -56,245 +166,499 @@ Macro* find_macro(const char *name) {
  * @brief Adds a line of preprocessed code to the context.
  *
  * This function adds a line to the preprocessed lines in the context. If necessary,
- * it reallocates memory to accommodate additional lines.
+ * it reallocates memory to accommodate additional lines. Only the pointer is stored,
+ * so the line must outlive the context.
  *
  * @param context Pointer to the Context structure containing preprocessed lines.
- * @param line The line to add.
+ * @param line The line to add, which must outlive the context.
  */
 void add_preprocessed_line(Context *context, const char *line) {
     if (context->line_count >= context->line_capacity) {
         context->line_capacity *= 2;
-        context->preprocessed_lines = (char **)realloc(context->preprocessed_lines, context->line_capacity * sizeof(char *));
+        context->preprocessed_lines = (const char **)counted_realloc(context->preprocessed_lines, context->line_capacity * sizeof(char *));
         if (context->preprocessed_lines == NULL) {
-            add_error(ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
+            add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
             return;
         }
     }
-    context->preprocessed_lines[context->line_count] = str_duplicate(line);
+    context->preprocessed_lines[context->line_count] = line;
     context->line_count++;
 }
 
-/**
- * @brief Expands macros in the source file.
- *
- * This function processes the source file, expanding macros as it encounters them.
- * The expanded lines are added to the context's preprocessed lines.
- *
- * @param input Pointer to the input file.
- * @param context Pointer to the Context structure to store preprocessed lines.
- */
-void expand_macros(FILE *input, Context *context) {
-    char *line;
-    char *line_duplicate;
-    char *token;
-    Macro *macro;
-    int i;
-    bool skip_lines = false;
-
-    context->line_number = 1;
-    while ((line = read_line(input)) != NULL) {
-        line_duplicate = str_duplicate(line);
-        token = strtok(line_duplicate, " \t\n");
-
-        if (token != NULL) {
-            if (strcmp(token, "macr") == 0) {
-                skip_lines = true;
-            } else if (strcmp(token, "endmacr") == 0) {
-                skip_lines = false;
-                free(line_duplicate);
-                free(line);
-                context->line_number++;
-                continue;
-            }
-
-            if (skip_lines) {
-                free(line_duplicate);
-                free(line);
-                context->line_number++;
-                continue;
-            }
-
-            macro = find_macro(token);
-            if (macro != NULL) {
-                for (i = 0; i < macro->line_count; i++) {
-                    add_preprocessed_line(context, macro->lines[i]);
-                }
-            } else {
-                add_preprocessed_line(context, line);
-            }
-        } else {
-            add_preprocessed_line(context, "");
-        }
-        free(line_duplicate);
-        free(line);
-        context->line_number++;
-    }
-}
-
 /**
  * @brief Processes a macro definition.
  *
- * This function reads the lines of a macro definition from the input file and stores
- * them in a new Macro structure. It then adds the macro to the macro list.
+ * This function reads the lines of a macro definition from the input file, up to and
+ * including its endmacr line, and stores pointers to them in a new Macro structure. It
+ * then adds the macro to the macro list. If the name is missing or invalid, the error
+ * is reported and the body is skipped. Each blank line of the definition is also kept
+ * as a blank preprocessed line, so later lines keep their place in the .am file.
  *
- * @param input Pointer to the input file.
- * @param name The name of the macro being defined.
+ * @param input Pointer to the line reader of the input file, positioned after the macr line.
+ * @param name The name of the macro being defined, or NULL if the name is missing.
  * @param context Pointer to the Context structure for error reporting.
+ * @param macros Pointer to the macro table the macro is added to.
  * @return True if the macro was successfully processed, false otherwise.
  */
-bool process_macro_definition(FILE *input, char *name, Context *context) {
-    int i;
-    Macro *new_macro;
+bool process_macro_definition(LineReader *input, char *name, Context *context, MacroTable *macros) {
+    Macro *new_macro = NULL;
     char *line;
     char *trimmed_line;
+    bool success = true;
 
-    if (!validate_macro_name(name)) {
-        add_error(ERR_MACRO_NAME_IS_NOT_VALID, context->filename, context->line_number, name);
-        return false;
-    }
+    if (name == NULL) {
+        add_error(context->errors, ERR_MACRO_NAME_MISSING, context->filename, context->line_number, NULL);
+        success = false;
+    } else if (!validate_macro_name(name)) {
+        add_error(context->errors, ERR_MACRO_NAME_IS_NOT_VALID, context->filename, context->line_number, name);
+        success = false;
+    } else {
+        new_macro = (Macro *)counted_malloc(sizeof(Macro));
+        if (new_macro == NULL) {
+            add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
+            return false;
+        }
 
-    new_macro = (Macro *)malloc(sizeof(Macro));
-    if (new_macro == NULL) {
-        add_error(ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
-        return false;
+        strncpy(new_macro->name, name, sizeof(new_macro->name) - 1);
+        new_macro->name[sizeof(new_macro->name) - 1] = NULL_TERMINATOR;
+        new_macro->lines = NULL;
+        new_macro->line_count = 0;
+        new_macro->next = NULL;
     }
 
-    strncpy(new_macro->name, name, sizeof(new_macro->name));
-    new_macro->lines = NULL;
-    new_macro->line_count = 0;
-    new_macro->next = NULL;
-
-    while ((line = read_line(input)) != NULL) {
+    while ((line = read_next_line(input)) != NULL) {
+        context->line_number++;
+        if (line[strspn(line, TOKEN_SEPARATORS)] == NULL_TERMINATOR) {
+            add_preprocessed_line(context, "");  /* Blank lines of a definition stay in the output */
+        }
         trimmed_line = trim_whitespace(line);
         if (strncmp(trimmed_line, "endmacr", 7) == 0) {
-            free(line);
             break;
         }
+        if (new_macro == NULL) {
+            continue;  /* Skip the body of an invalid definition */
+        }
 
         new_macro->line_count++;
-        new_macro->lines = (char **)realloc(new_macro->lines, new_macro->line_count * sizeof(char *));
+        new_macro->lines = (const char **)counted_realloc(new_macro->lines, new_macro->line_count * sizeof(char *));
         if (new_macro->lines == NULL) {
-            add_error(ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
-            free(line);
-            for (i = 0; i < new_macro->line_count - 1; i++) {
-                free(new_macro->lines[i]);
-            }
-            free(new_macro->lines);
+            add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
             free(new_macro);
             return false;
         }
         new_macro->lines[new_macro->line_count - 1] = line;
-        context->line_number++;
     }
 
-    add_macro(new_macro);
-    return true;
+    if (new_macro != NULL && !add_macro(macros, new_macro)) {
+        add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
+        free(new_macro->lines);
+        free(new_macro);
+        return false;
+    }
+    return success;
 }
 
 /**
  * @brief Frees the memory used by the context.
  *
- * This function frees the memory allocated for the preprocessed lines in the context.
+ * This function frees the source buffer and the array of preprocessed lines in the
+ * context. The lines themselves point into source buffers and are not freed one by one.
  *
  * @param context Pointer to the Context structure to be freed.
  */
 void free_context(Context *context) {
-    int i;
-    for (i = 0; i < context->line_count; i++) {
-        free(context->preprocessed_lines[i]);
-    }
+    free(context->source);
+    context->source = NULL;
     free(context->preprocessed_lines);
     context->preprocessed_lines = NULL;
+    context->line_count = 0;
+    free(context->deferred_lines);
+    context->deferred_lines = NULL;
+    context->deferred_count = 0;
 }
 
 /**
- * @brief Frees the memory used by the macro list.
+ * @brief Frees a chain of macros linked through their next pointers.
  *
- * This function frees the memory allocated for all macros in the macro list.
+ * @param macro The first macro of the chain, or NULL.
  */
-void free_macros() {
-    int i;
-    Macro *current = macro_list;
+static void free_macro_chain(Macro *macro) {
     Macro *next;
 
-    while (current != NULL) {
-        next = current->next;
-        for (i = 0; i < current->line_count; i++) {
-            free(current->lines[i]);
+    while (macro != NULL) {
+        next = macro->next;
+        free(macro->lines);
+        free(macro);
+        macro = next;
+    }
+}
+
+/**
+ * @brief Records that a line may be a call of a macro defined by an earlier file.
+ *
+ * @param context Pointer to the Context of the file.
+ * @param index The index of the line among the preprocessed lines.
+ * @param name The first token of the line.
+ * @param length The length of the first token.
+ * @param hash The hash of the first token.
+ */
+static void add_deferred_line(Context *context, int index, const char *name, size_t length, unsigned long hash) {
+    int capacity;
+    DeferredLine *lines;
+    DeferredLine *line;
+
+    if (context->deferred_count >= context->deferred_capacity) {
+        capacity = (context->deferred_capacity == 0) ? INITIAL_DEFERRED_CAPACITY : context->deferred_capacity * 2;
+        lines = (DeferredLine *)counted_realloc(context->deferred_lines, capacity * sizeof(DeferredLine));
+        if (lines == NULL) {
+            add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, context->line_number, NULL);
+            return;
         }
-        free(current->lines);
-        free(current);
-        current = next;
+        context->deferred_lines = lines;
+        context->deferred_capacity = capacity;
     }
-    macro_list = NULL;
+    line = &context->deferred_lines[context->deferred_count++];
+    line->index = index;
+    line->name = name;
+    line->length = length;
+    line->hash = hash;
+}
+
+/**
+ * @brief Frees the memory used by the macro table.
+ *
+ * This function frees the memory allocated for all macros in the table, including
+ * ones that were replaced by a later definition of the same name. The macro lines
+ * belong to the source buffers of their contexts.
+ *
+ * @param table Pointer to the MacroTable to free.
+ */
+void free_macros(MacroTable *table) {
+    free_macro_chain(table->head);
+    free(table->slots);
+    init_macro_table(table);
 }
 
 /**
  * @brief Preprocesses the input file by expanding macros.
  *
- * This function reads the input file, processes any macro definitions, and expands them.
- * The expanded lines are stored in the context structure.
+ * This function reads the input file once. Macro definitions are recorded as they are
+ * met and every later use of a macro is expanded in place, so a macro must be defined
+ * before it is used. The expanded lines are stored in the context structure.
+ *
+ * The file is read into a single buffer that the context keeps, and each line is
+ * null-terminated in place. The preprocessed lines and macro bodies point straight
+ * into that buffer, so no line is ever copied. The first token of each line is also
+ * null-terminated in place just long enough to be compared.
+ *
+ * When lines are deferred, a line that starts with a name that is neither a known
+ * macro nor a keyword is recorded, so that join_preprocessed_file can expand it later
+ * if an earlier file turns out to define a macro by that name. Names that end with a
+ * colon are taken to be labels and are not recorded, which keeps the record small.
  *
  * @param filename The name of the input file.
+ * @param text The source text of the file, or NULL to read it from the file.
+ * @param length The number of bytes of text.
  * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param assembler Pointer to the assembler context holding the macros and errors.
+ * @param defer_lines Whether to record the lines that may call macros of earlier files.
  * @return True if preprocessing was successful, false otherwise.
  */
-bool preprocess(const char *filename, Context *context) {
-    FILE *input;
+static bool preprocess_file(const char *filename, const char *text, size_t length, Context *context, AssemblerContext *assembler, bool defer_lines) {
+    LineReader input;
     char *line;
     char *token;
     char *macro_name;
+    size_t token_length;
+    size_t name_length;
+    char separator;
+    unsigned long hash;
+    Macro *macro;
+    int i;
     bool success = true;
 
     context->filename = filename;
     context->line_number = 1;
-    context->preprocessed_lines = (char **)malloc(INITIAL_LINE_CAPACITY * sizeof(char *));
+    context->source = NULL;
+    context->errors = &assembler->errors;
+    context->deferred_lines = NULL;
+    context->deferred_count = 0;
+    context->deferred_capacity = 0;
+    context->preprocessed_lines = (const char **)counted_malloc(INITIAL_LINE_CAPACITY * sizeof(char *));
     context->line_count = 0;
     context->line_capacity = INITIAL_LINE_CAPACITY;
 
     if (context->preprocessed_lines == NULL) {
-        add_error(ERR_MEMORY_ALLOCATION_FAILED, filename, 0, NULL);
+        add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, filename, 0, NULL);
         return false;
     }
 
-    input = fopen(filename, "r");
-    if (!input) {
-        add_error(ERR_FILE_NOT_FOUND, filename, 0, NULL);
+    if (text != NULL && !open_line_buffer(&input, text, length)) {
+        add_error(context->errors, ERR_MEMORY_ALLOCATION_FAILED, filename, 0, NULL);
+        free(context->preprocessed_lines);
+        context->preprocessed_lines = NULL;
+        return false;
+    }
+    if (text == NULL && !open_line_reader(&input, filename)) {
+        add_error(context->errors, ERR_FILE_NOT_FOUND, filename, 0, NULL);
         free(context->preprocessed_lines);
+        context->preprocessed_lines = NULL;
         return false;
     }
 
-    /* First pass: check for macros and process definitions */
-    while ((line = read_line(input)) != NULL) {
-        token = strtok(line, " \t\n");
-        if (token != NULL && strcmp(token, "macr") == 0) {
-            macro_name = strtok(NULL, " \t\n");
-            if (macro_name != NULL) {
-                if (!process_macro_definition(input, macro_name, context)) {
+    while ((line = read_next_line(&input)) != NULL) {
+        token = line + strspn(line, TOKEN_SEPARATORS);
+        token_length = strcspn(token, TOKEN_SEPARATORS);
+
+        if (token_length == 0) {
+            add_preprocessed_line(context, "");
+        } else {
+            separator = token[token_length];
+            token[token_length] = NULL_TERMINATOR;
+
+            if (strcmp(token, "macr") == 0) {
+                macro_name = NULL;
+                if (separator != NULL_TERMINATOR) {
+                    macro_name = token + token_length + 1;
+                    macro_name += strspn(macro_name, TOKEN_SEPARATORS);
+                    name_length = strcspn(macro_name, TOKEN_SEPARATORS);
+                    if (name_length == 0) {
+                        macro_name = NULL;
+                    } else {
+                        macro_name[name_length] = NULL_TERMINATOR;
+                    }
+                }
+                if (!process_macro_definition(&input, macro_name, context, &assembler->macros)) {
                     success = false;
                 }
-            } else {
-                add_error(ERR_MACRO_NAME_MISSING, filename, context->line_number, NULL);
-                success = false;
+            } else if (strcmp(token, "endmacr") != 0) {
+                macro = NULL;
+                hash = 0;
+                if (assembler->macros.count > 0 || defer_lines) {
+                    hash = hash_string(token);
+                    macro = find_macro_span(&assembler->macros, token, token_length, hash);
+                }
+                token[token_length] = separator;  /* Restore the line */
+                if (macro != NULL) {
+                    add_to_counter(COUNTER_MACRO_EXPANSIONS, 1);
+                    for (i = 0; i < macro->line_count; i++) {
+                        add_preprocessed_line(context, macro->lines[i]);
+                    }
+                } else {
+                    if (defer_lines && token_length < MACRO_NAME_SIZE && isalpha((unsigned char) token[0])
+                            && token[token_length - 1] != ':' && find_keyword(token, token_length) == NULL) {
+                        add_deferred_line(context, context->line_count, token, token_length, hash);
+                    }
+                    add_preprocessed_line(context, line);
+                }
             }
         }
-
         context->line_number++;
-        free(line);
     }
 
-    fclose(input);
+    context->source = release_line_reader(&input);
+
+    return success && !has_errors(&assembler->errors);
+}
+
+/**
+ * @brief Preprocesses the input file by expanding macros.
+ *
+ * Macros defined by earlier files of the assembly are already in the shared macro
+ * table and are expanded like the file's own.
+ *
+ * @param filename The name of the input file.
+ * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param assembler Pointer to the assembler context holding the macros and errors of the assembly.
+ * @return True if preprocessing was successful, false otherwise.
+ */
+bool preprocess(const char *filename, Context *context, AssemblerContext *assembler) {
+    return preprocess_file(filename, NULL, 0, context, assembler, false);
+}
+
+/**
+ * @brief Preprocesses source text held in memory by expanding macros.
+ *
+ * This is preprocess for a file whose contents the caller already holds; the name is
+ * only used to report errors and to tell the files apart.
+ *
+ * @param filename The name of the source.
+ * @param text The source text; it need not be null-terminated.
+ * @param length The number of bytes of text.
+ * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param assembler Pointer to the assembler context holding the macros and errors of the assembly.
+ * @return True if preprocessing was successful, false otherwise.
+ */
+bool preprocess_text(const char *filename, const char *text, size_t length, Context *context, AssemblerContext *assembler) {
+    if (text == NULL) {
+        text = "";
+        length = 0;
+    }
+    return preprocess_file(filename, text, length, context, assembler, false);
+}
+
+/**
+ * @brief Preprocesses the input file on its own, without the macros of other files.
+ *
+ * @param filename The name of the input file.
+ * @param context Pointer to the Context structure to store preprocessed lines.
+ * @param file_assembler Pointer to an assembler context of this file alone.
+ * @return True if preprocessing was successful, false otherwise.
+ */
+bool preprocess_isolated(const char *filename, Context *context, AssemblerContext *file_assembler) {
+    return preprocess_file(filename, NULL, 0, context, file_assembler, true);
+}
+
+/**
+ * @brief Expands the deferred lines of a file that call macros of earlier files.
+ *
+ * The lines are rebuilt into a new array only if at least one deferred line turns out
+ * to be a macro call.
+ *
+ * @param context Pointer to the Context of the file.
+ * @param macros The macro table holding the macros of the earlier files.
+ * @return True if the lines were expanded, false if memory allocation failed.
+ */
+static bool expand_deferred_lines(Context *context, const MacroTable *macros) {
+    const DeferredLine *deferred;
+    Macro **found;
+    const char **lines;
+    int count = context->line_count;
+    int calls = 0;
+    int i, j, k;
+
+    if (macros->count == 0 || context->deferred_count == 0) {
+        return true;
+    }
+
+    found = (Macro **)counted_calloc(context->deferred_count, sizeof(Macro *));
+    if (found == NULL) {
+        return false;
+    }
 
-    /* Expand macros and write to the output file */
-    input = fopen(filename, "r");
-    if (!input) {
-        add_error(ERR_FILE_NOT_FOUND, filename, 0, NULL);
+    for (i = 0; i < context->deferred_count; i++) {
+        deferred = &context->deferred_lines[i];
+        found[i] = find_macro_span(macros, deferred->name, deferred->length, deferred->hash);
+        if (found[i] != NULL) {
+            count += found[i]->line_count - 1;
+            calls++;
+        }
+    }
+
+    if (calls == 0) {
+        free(found);
+        return true;
+    }
+
+    lines = (const char **)counted_malloc((count > 0 ? count : 1) * sizeof(char *));
+    if (lines == NULL) {
+        free(found);
         return false;
     }
 
-    expand_macros(input, context);
+    for (i = 0, j = 0, k = 0; i < context->line_count; i++) {
+        if (k < context->deferred_count && context->deferred_lines[k].index == i) {
+            if (found[k] != NULL) {
+                add_to_counter(COUNTER_MACRO_EXPANSIONS, 1);
+                if (found[k]->line_count > 0) {
+                    memcpy(lines + j, found[k]->lines, found[k]->line_count * sizeof(char *));
+                    j += found[k]->line_count;
+                }
+                k++;
+                continue;
+            }
+            k++;
+        }
+        lines[j++] = context->preprocessed_lines[i];
+    }
+
+    free(context->preprocessed_lines);
+    context->preprocessed_lines = lines;
+    context->line_count = count;
+    context->line_capacity = (count > 0 ? count : 1);
+    free(found);
+    return true;
+}
 
-    fclose(input);
+/**
+ * @brief Checks whether a macro table holds a macro whose name ends with a colon.
+ *
+ * Such a macro could be called from a line that looks like a label, which
+ * preprocess_isolated does not record.
+ *
+ * @param table The macro table.
+ * @return True if such a macro exists, false otherwise.
+ */
+static bool has_label_like_macro(const MacroTable *table) {
+    const Macro *macro;
+
+    for (macro = table->head; macro != NULL; macro = macro->next) {
+        if (macro->name[strlen(macro->name) - 1] == ':') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Joins a file that was preprocessed on its own into the whole assembly.
+ *
+ * Files must be joined in order. The file's deferred lines are expanded with the
+ * macros of the files joined before it, its errors are appended to the assembly's,
+ * and its macros move into the shared table in the order they were defined, so the
+ * result is the same as preprocessing the files one after another. In the rare case
+ * that an earlier file defines a macro named like a label, the file is simply
+ * preprocessed again with the shared table.
+ *
+ * @param context Pointer to the Context of the file.
+ * @param file_assembler Pointer to the assembler context the file was preprocessed with; it is freed.
+ * @param assembler Pointer to the assembler context of the whole assembly.
+ * @return True if the file was joined, false if memory allocation failed.
+ */
+bool join_preprocessed_file(Context *context, AssemblerContext *file_assembler, AssemblerContext *assembler) {
+    Macro *reversed = NULL;
+    Macro *macro = file_assembler->macros.head;
+    Macro *next;
+    bool success = true;
+
+    if (has_label_like_macro(&assembler->macros)) {
+        free_context(context);
+        free_assembler_context(file_assembler);
+        return preprocess(context->filename, context, assembler);
+    }
+
+    append_errors(&assembler->errors, &file_assembler->errors);
+    context->errors = &assembler->errors;
+
+    if (!expand_deferred_lines(context, &assembler->macros)) {
+        add_error(&assembler->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, 0, NULL);
+        success = false;
+    }
+    free(context->deferred_lines);
+    context->deferred_lines = NULL;
+    context->deferred_count = 0;
+    context->deferred_capacity = 0;
+
+    /* The chain runs from the newest macro back, so reverse it to add in definition order */
+    while (macro != NULL) {
+        next = macro->next;
+        macro->next = reversed;
+        reversed = macro;
+        macro = next;
+    }
+    while (reversed != NULL) {
+        next = reversed->next;
+        if (!add_macro(&assembler->macros, reversed)) {
+            add_error(&assembler->errors, ERR_MEMORY_ALLOCATION_FAILED, context->filename, 0, NULL);
+            reversed->next = next;
+            free_macro_chain(reversed);
+            success = false;
+            break;
+        }
+        reversed = next;
+    }
 
-    return success && !has_errors();
+    file_assembler->macros.head = NULL;
+    free_assembler_context(file_assembler);
+    return success;
 }
@@ -0,0 +1,141 @@
+/**
+ * @file reader.c
+ * @brief Implements the block-reading line reader used by the preprocessor.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "reader.h"
+#include "stats.h"
+
+#define READ_BLOCK_SIZE 65536
+
+/**
+ * @brief Reads a whole file into a line reader.
+ *
+ * The file is read in large blocks into a buffer that doubles as needed, so this works
+ * for any stream, not only for files whose size can be queried up front. One byte is
+ * always kept free so the last line can be null-terminated even without a newline.
+ *
+ * @param reader Pointer to the LineReader to fill.
+ * @param path The path of the file to read.
+ * @return True if the file was read, false if it could not be opened or memory allocation failed.
+ */
+bool open_line_reader(LineReader *reader, const char *path) {
+    FILE *file;
+    size_t capacity = READ_BLOCK_SIZE;
+    size_t count;
+    char *data;
+
+    reader->data = NULL;
+    reader->length = 0;
+    reader->position = 0;
+
+    file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    reader->data = (char *)counted_malloc(capacity);
+    if (reader->data == NULL) {
+        fclose(file);
+        return false;
+    }
+
+    while ((count = fread(reader->data + reader->length, 1, capacity - 1 - reader->length, file)) > 0) {
+        reader->length += count;
+        if (reader->length == capacity - 1) {
+            capacity *= 2;
+            data = (char *)counted_realloc(reader->data, capacity);
+            if (data == NULL) {
+                fclose(file);
+                close_line_reader(reader);
+                return false;
+            }
+            reader->data = data;
+        }
+    }
+    reader->data[reader->length] = NULL_TERMINATOR;
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * @brief Fills a line reader with a copy of source text held in memory.
+ *
+ * The text is copied because lines are null-terminated in place, which must not
+ * touch the caller's text.
+ *
+ * @param reader Pointer to the LineReader to fill.
+ * @param text The source text; it need not be null-terminated.
+ * @param length The number of bytes of text.
+ * @return True if the text was copied, false if memory allocation failed.
+ */
+bool open_line_buffer(LineReader *reader, const char *text, size_t length) {
+    reader->length = 0;
+    reader->position = 0;
+    reader->data = (char *)counted_malloc(length + 1);
+    if (reader->data == NULL) {
+        return false;
+    }
+
+    if (length > 0) {
+        memcpy(reader->data, text, length);
+    }
+    reader->data[length] = NULL_TERMINATOR;
+    reader->length = length;
+    return true;
+}
+
+/**
+ * @brief Reads the next line of the file, null-terminating it in place.
+ *
+ * @param reader Pointer to the LineReader.
+ * @return The null-terminated line without its newline, or NULL at the end of the file.
+ */
+char* read_next_line(LineReader *reader) {
+    char *line = reader->data + reader->position;
+    size_t remaining = reader->length - reader->position;
+    char *newline;
+
+    if (remaining == 0) {
+        return NULL;
+    }
+
+    newline = (char *)memchr(line, '\n', remaining);
+    if (newline != NULL) {
+        *newline = NULL_TERMINATOR;
+        reader->position += (size_t)(newline - line) + 1;
+    } else {
+        reader->position = reader->length;  /* Last line, already terminated by open_line_reader */
+    }
+    return line;
+}
+
+/**
+ * @brief Hands the file contents over to the caller and empties the reader.
+ *
+ * @param reader Pointer to the LineReader.
+ * @return The file contents, which the caller must free.
+ */
+char* release_line_reader(LineReader *reader) {
+    char *data = reader->data;
+    reader->data = NULL;
+    reader->length = 0;
+    reader->position = 0;
+    return data;
+}
+
+/**
+ * @brief Frees the file contents held by a line reader.
+ *
+ * @param reader Pointer to the LineReader to close.
+ */
+void close_line_reader(LineReader *reader) {
+    free(reader->data);
+    reader->data = NULL;
+    reader->length = 0;
+    reader->position = 0;
+}
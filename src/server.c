@@ -0,0 +1,373 @@
+/**
+ * @file server.c
+ * @brief Implements the assembler server and the client that sends it builds.
+ *
+ * Messages are sequences of 32-bit big-endian numbers and blocks, where a block is a
+ * length followed by that many bytes. A request is SERVER_MAGIC, the number of files,
+ * the error limit, and the name and contents block of each file. A response is one block holding the
+ * BuildResult, as encoded by encode_build_result.
+ */
+
+#define _POSIX_C_SOURCE 199506L  /* Sockets and signals */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "reader.h"
+#include "stats.h"
+
+#define TRANSFER_BLOCK_SIZE 4096  /* Bytes received per read while filling a buffer */
+
+/**
+ * @brief Writes all of a byte range to a socket.
+ *
+ * @param fd The socket to write to.
+ * @param data The bytes to write.
+ * @param length The number of bytes to write.
+ * @return True if every byte was written, false otherwise.
+ */
+static bool write_all(int fd, const char *data, size_t length) {
+    ssize_t written;
+
+    while (length > 0) {
+        written = write(fd, data, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        length -= (size_t) written;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads an exact number of bytes from a socket.
+ *
+ * @param fd The socket to read from.
+ * @param data The memory to read into.
+ * @param length The number of bytes to read.
+ * @return True if every byte was read, false if the socket failed or closed early.
+ */
+static bool read_all(int fd, char *data, size_t length) {
+    ssize_t count;
+
+    while (length > 0) {
+        count = read(fd, data, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        length -= (size_t) count;
+    }
+    return true;
+}
+
+/**
+ * @brief Sends a number as four big-endian bytes.
+ *
+ * @param fd The socket to write to.
+ * @param value The number to send.
+ * @return True if the number was sent, false otherwise.
+ */
+static bool send_number(int fd, unsigned long value) {
+    char bytes[4];
+
+    bytes[0] = (char)((value >> 24) & 0xFF);
+    bytes[1] = (char)((value >> 16) & 0xFF);
+    bytes[2] = (char)((value >> 8) & 0xFF);
+    bytes[3] = (char)(value & 0xFF);
+    return write_all(fd, bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Receives a number sent by send_number.
+ *
+ * @param fd The socket to read from.
+ * @param value Pointer to store the number.
+ * @return True if a number no larger than MAX_MESSAGE_LENGTH was received, false otherwise.
+ */
+static bool receive_number(int fd, unsigned long *value) {
+    unsigned char bytes[4];
+
+    if (!read_all(fd, (char *)bytes, sizeof(bytes))) {
+        return false;
+    }
+    *value = ((unsigned long)bytes[0] << 24) | ((unsigned long)bytes[1] << 16)
+           | ((unsigned long)bytes[2] << 8) | (unsigned long)bytes[3];
+    return *value <= MAX_MESSAGE_LENGTH;
+}
+
+/**
+ * @brief Sends a length-prefixed block of bytes.
+ *
+ * @param fd The socket to write to.
+ * @param data The bytes to send.
+ * @param length The number of bytes to send.
+ * @return True if the block was sent, false otherwise.
+ */
+static bool send_block(int fd, const char *data, size_t length) {
+    if (length > MAX_MESSAGE_LENGTH) {
+        return false;
+    }
+    return send_number(fd, (unsigned long) length) && write_all(fd, data, length);
+}
+
+/**
+ * @brief Receives a block sent by send_block into a buffer.
+ *
+ * @param fd The socket to read from.
+ * @param block Pointer to the Buffer the bytes are appended to.
+ * @return True if the block was received, false otherwise.
+ */
+static bool receive_block(int fd, Buffer *block) {
+    unsigned long remaining;
+    size_t count;
+    char bytes[TRANSFER_BLOCK_SIZE];
+
+    if (!receive_number(fd, &remaining)) {
+        return false;
+    }
+    while (remaining > 0) {
+        count = remaining < sizeof(bytes) ? (size_t) remaining : sizeof(bytes);
+        if (!read_all(fd, bytes, count) || !buffer_append(block, bytes, count)) {
+            return false;
+        }
+        remaining -= count;
+    }
+    return true;
+}
+
+/**
+ * @brief Receives a block sent by send_block as a null-terminated string.
+ *
+ * @param fd The socket to read from.
+ * @param length Pointer to store the number of bytes received.
+ * @return The received bytes, which the caller must free, or NULL on failure.
+ */
+static char* receive_string(int fd, size_t *length) {
+    Buffer block;
+
+    init_buffer(&block);
+    if (!receive_block(fd, &block)) {
+        free_buffer(&block);
+        return NULL;
+    }
+    return release_buffer(&block, length);
+}
+
+/**
+ * @brief Bounds how long a read or write on a socket may block.
+ *
+ * A read or write that times out fails like one on a closed socket, so a peer that
+ * stalls mid-message is dropped instead of blocking the other end forever.
+ *
+ * @param fd The socket.
+ * @param seconds The longest a single read or write may block.
+ * @return True if both timeouts were set, false otherwise.
+ */
+static bool set_timeouts(int fd, int seconds) {
+    struct timeval timeout;
+
+    timeout.tv_sec = seconds;
+    timeout.tv_usec = 0;
+    return setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0
+        && setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+/**
+ * @brief Fills a Unix domain socket address.
+ *
+ * @param address Pointer to the address to fill.
+ * @param socket_path The path of the socket.
+ * @return True if the path fits in the address, false otherwise.
+ */
+static bool make_address(struct sockaddr_un *address, const char *socket_path) {
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "Socket path is too long: %s\n", socket_path);
+        return false;
+    }
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+/**
+ * @brief Receives one request from a client, builds it and sends back the result.
+ *
+ * A malformed request is dropped without a response.
+ *
+ * @param fd The socket of the client.
+ * @param jobs The number of threads to parse with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ */
+static void handle_request(int fd, int jobs, bool single_pass) {
+    int i, file_count = 0;
+    unsigned long count, max_errors;
+    bool received = false;
+    char magic[sizeof(SERVER_MAGIC) - 1];
+    char **names = NULL;
+    char **texts = NULL;
+    size_t *lengths = NULL;
+    size_t name_length;
+    BuildResult result;
+    Buffer response;
+
+    if (read_all(fd, magic, sizeof(magic)) && memcmp(magic, SERVER_MAGIC, sizeof(magic)) == 0
+            && receive_number(fd, &count) && count > 0 && count <= MAX_REQUEST_FILES
+            && receive_number(fd, &max_errors)) {
+        names = (char **)counted_calloc(count, sizeof(char *));
+        texts = (char **)counted_calloc(count, sizeof(char *));
+        lengths = (size_t *)counted_calloc(count, sizeof(size_t));
+        received = names != NULL && texts != NULL && lengths != NULL;
+        for (i = 0; received && i < (int) count; i++) {
+            names[i] = receive_string(fd, &name_length);
+            texts[i] = names[i] != NULL ? receive_string(fd, &lengths[i]) : NULL;
+            file_count = i + 1;
+            received = texts[i] != NULL;
+        }
+    }
+
+    if (received) {
+        init_build_result(&result);
+        init_buffer(&response);
+        build_sources(file_count, (const char **)names, (const char **)texts, lengths, jobs, single_pass, (int) max_errors, &result);
+        if (encode_build_result(&result, &response)) {
+            send_block(fd, response.data, response.length);
+        }
+        free_buffer(&response);
+        free_build_result(&result);
+    }
+
+    for (i = 0; i < file_count; i++) {
+        free(names[i]);
+        free(texts[i]);
+    }
+    free(names);
+    free(texts);
+    free(lengths);
+}
+
+/**
+ * @brief Serves builds on a Unix domain socket until the process is stopped.
+ *
+ * Requests are built one at a time, in the order their connections are accepted. A
+ * client that stalls for SERVER_TIMEOUT_SECONDS is dropped, so it cannot hold up the
+ * clients queued behind it.
+ *
+ * @param socket_path The path of the socket; an existing file at the path is replaced.
+ * @param jobs The number of threads to parse each build with.
+ * @param single_pass Whether to patch label references as labels are declared rather than in a second pass.
+ * @return False if the socket could not be set up; otherwise the function does not return.
+ */
+bool serve(const char *socket_path, int jobs, bool single_pass) {
+    int listener, client;
+    struct sockaddr_un address;
+
+    if (!make_address(&address, socket_path)) {
+        return false;
+    }
+
+    /* A client that goes away must not take the server down with it */
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        fprintf(stderr, "Failed to create socket %s\n", socket_path);
+        return false;
+    }
+    unlink(socket_path);
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(listener, SOMAXCONN) < 0) {
+        fprintf(stderr, "Failed to listen on socket %s\n", socket_path);
+        close(listener);
+        return false;
+    }
+    printf("Serving on %s\n", socket_path);
+    fflush(stdout);
+
+    for (;;) {
+        client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            continue;
+        }
+        if (set_timeouts(client, SERVER_TIMEOUT_SECONDS)) {
+            handle_request(client, jobs, single_pass);
+        }
+        close(client);
+    }
+}
+
+/**
+ * @brief Has a server build source files read from disk.
+ *
+ * @param socket_path The path of the server's socket.
+ * @param file_count The number of files.
+ * @param filenames The source filenames, each ending in ".as".
+ * @param max_errors The number of errors after which the build stops reporting errors, or 0 for no limit.
+ * @param result Pointer to the initialized BuildResult to fill.
+ * @return True if the server built the files, false if the files could not be read or
+ *         the server could not be reached, timed out or sent a short response; the result
+ *         is left empty in that case.
+ */
+bool request_build(const char *socket_path, int file_count, const char **filenames, int max_errors, BuildResult *result) {
+    int i, fd = -1, read_count = 0;
+    bool success;
+    char *response = NULL;
+    size_t response_length;
+    LineReader *sources;
+    struct sockaddr_un address;
+
+    sources = (LineReader *)counted_malloc((file_count > 0 ? file_count : 1) * sizeof(LineReader));
+    success = sources != NULL && file_count <= MAX_REQUEST_FILES && make_address(&address, socket_path);
+
+    /* Files that cannot be read are left to the local build, which reports them */
+    for (i = 0; success && i < file_count; i++) {
+        success = open_line_reader(&sources[i], filenames[i]);
+        read_count = success ? i + 1 : i;
+    }
+
+    if (success) {
+        signal(SIGPIPE, SIG_IGN);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        success = fd >= 0 && set_timeouts(fd, CLIENT_TIMEOUT_SECONDS)
+               && connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+    }
+
+    if (success) {
+        success = write_all(fd, SERVER_MAGIC, sizeof(SERVER_MAGIC) - 1) && send_number(fd, (unsigned long) file_count)
+               && send_number(fd, (unsigned long) max_errors);
+        for (i = 0; success && i < file_count; i++) {
+            success = send_block(fd, filenames[i], strlen(filenames[i]))
+                   && send_block(fd, sources[i].data, sources[i].length);
+        }
+        response = success ? receive_string(fd, &response_length) : NULL;
+        success = response != NULL && decode_build_result(response, response_length, file_count, result);
+        if (!success) {
+            free_build_result(result);
+        }
+    }
+
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(response);
+    for (i = 0; i < read_count; i++) {
+        close_line_reader(&sources[i]);
+    }
+    free(sources);
+    return success;
+}
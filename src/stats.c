@@ -0,0 +1,233 @@
+/**
+ * @file stats.c
+ * @brief Collects the per-stage wall times and counters reported by the --stats option.
+ */
+
+#define _POSIX_C_SOURCE 199506L  /* clock_gettime, pthreads */
+#define _XOPEN_SOURCE 500         /* getrusage */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "stats.h"
+
+/** Whether stage timing is enabled; set once before any worker thread starts. */
+static bool stats_flag = false;
+/** Key of the Stats each thread accumulates into; created once by enable_stats. */
+static pthread_key_t stats_key;
+
+/** Names of the stages, in Stage order. */
+static const char *stage_names[] = {
+        "preprocess",
+        "first pass",
+        "address adjustment",
+        "second pass",
+        "output writing"
+};
+
+/** Names of the counters, in Counter order. */
+static const char *counter_names[] = {
+        "lines",
+        "words emitted",
+        "labels",
+        "label lookups",
+        "macro expansions",
+        "mallocs",
+        "bytes written"
+};
+
+/**
+ * @brief Reads the monotonic clock.
+ *
+ * @return The current time in seconds.
+ */
+static double now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Initializes a Stats with zero timings and counters.
+ *
+ * @param stats Pointer to the Stats to initialize.
+ */
+void init_stats(Stats *stats) {
+    int i;
+
+    for (i = 0; i < STAGE_COUNT; i++) {
+        stats->stage_seconds[i] = 0;
+        stats->stage_start[i] = 0;
+    }
+    for (i = 0; i < COUNTER_COUNT; i++) {
+        stats->counters[i] = 0;
+    }
+}
+
+/**
+ * @brief Turns on stage timing and counting, accumulating into the given Stats.
+ *
+ * Must be called before any other thread is started.
+ *
+ * @param stats The Stats the calling thread accumulates into; the report is printed by print_stats.
+ */
+void enable_stats(Stats *stats) {
+    if (!stats_flag) {
+        if (pthread_key_create(&stats_key, NULL) != 0) {
+            fprintf(stderr, "Failed to set up --stats; no report will be printed\n");
+            return;
+        }
+        stats_flag = true;
+    }
+    attach_stats(stats);
+}
+
+/**
+ * @brief Makes the calling thread accumulate into the given Stats.
+ *
+ * @param stats The Stats of the calling thread.
+ */
+void attach_stats(Stats *stats) {
+    if (stats_flag) {
+        pthread_setspecific(stats_key, stats);
+    }
+}
+
+/**
+ * @brief Returns the Stats the calling thread accumulates into.
+ *
+ * @return The Stats of the calling thread, or NULL if stats are off or none is attached.
+ */
+Stats* thread_stats(void) {
+    if (!stats_flag) {
+        return NULL;
+    }
+    return (Stats *)pthread_getspecific(stats_key);
+}
+
+/**
+ * @brief Adds the counters of one Stats to another.
+ *
+ * Stage timers are not merged, since only the main thread times stages.
+ *
+ * @param into The Stats to add to.
+ * @param from The Stats whose counters are added.
+ */
+void merge_stats(Stats *into, const Stats *from) {
+    int i;
+
+    for (i = 0; i < COUNTER_COUNT; i++) {
+        into->counters[i] += from->counters[i];
+    }
+}
+
+/**
+ * @brief Starts timing a stage.
+ *
+ * @param stage The stage being entered.
+ */
+void begin_stage(Stage stage) {
+    Stats *stats = thread_stats();
+
+    if (stats != NULL) {
+        stats->stage_start[stage] = now();
+    }
+}
+
+/**
+ * @brief Stops timing a stage and adds the elapsed wall time to its total.
+ *
+ * @param stage The stage being left.
+ */
+void end_stage(Stage stage) {
+    Stats *stats = thread_stats();
+
+    if (stats != NULL) {
+        stats->stage_seconds[stage] += now() - stats->stage_start[stage];
+    }
+}
+
+/**
+ * @brief Adds an amount to a counter.
+ *
+ * The counter lives in the Stats of the calling thread, so no lock is taken. Counters
+ * are only kept while stats are enabled.
+ *
+ * @param counter The counter to increase.
+ * @param amount The amount to add.
+ */
+void add_to_counter(Counter counter, unsigned long amount) {
+    Stats *stats = thread_stats();
+
+    if (stats != NULL) {
+        stats->counters[counter] += amount;
+    }
+}
+
+/**
+ * @brief Prints the stage timings, counters and peak memory use to stderr if stats are enabled.
+ *
+ * @param stats The Stats to report.
+ */
+void print_stats(const Stats *stats) {
+    int i;
+    double total = 0;
+    struct rusage usage;
+
+    if (!stats_flag) {
+        return;
+    }
+
+    fprintf(stderr, "Stage timings:\n");
+    for (i = 0; i < STAGE_COUNT; i++) {
+        fprintf(stderr, "  %-20s %10.3f ms\n", stage_names[i], stats->stage_seconds[i] * 1000);
+        total += stats->stage_seconds[i];
+    }
+    fprintf(stderr, "  %-20s %10.3f ms\n", "total", total * 1000);
+
+    fprintf(stderr, "Counters:\n");
+    for (i = 0; i < COUNTER_COUNT; i++) {
+        fprintf(stderr, "  %-20s %10lu\n", counter_names[i], stats->counters[i]);
+    }
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        fprintf(stderr, "  %-20s %10ld KB\n", "peak memory", usage.ru_maxrss);
+    }
+}
+
+/**
+ * @brief Allocates memory with malloc and counts the allocation.
+ *
+ * @param size The number of bytes to allocate.
+ * @return A pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* counted_malloc(size_t size) {
+    add_to_counter(COUNTER_MALLOCS, 1);
+    return malloc(size);
+}
+
+/**
+ * @brief Allocates zeroed memory with calloc and counts the allocation.
+ *
+ * @param count The number of elements to allocate.
+ * @param size The size of each element.
+ * @return A pointer to the allocated memory, or NULL if allocation fails.
+ */
+void* counted_calloc(size_t count, size_t size) {
+    add_to_counter(COUNTER_MALLOCS, 1);
+    return calloc(count, size);
+}
+
+/**
+ * @brief Resizes memory with realloc and counts the allocation.
+ *
+ * @param ptr The memory to resize, or NULL.
+ * @param size The new size in bytes.
+ * @return A pointer to the resized memory, or NULL if allocation fails.
+ */
+void* counted_realloc(void *ptr, size_t size) {
+    add_to_counter(COUNTER_MALLOCS, 1);
+    return realloc(ptr, size);
+}
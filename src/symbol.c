@@ -0,0 +1,169 @@
+/**
+ * @file symbol.c
+ * @brief Interns symbol names as small integer IDs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "symbol.h"
+#include "stats.h"
+
+#define INITIAL_SYMBOL_CAPACITY 64
+
+/**
+ * @brief Finds the slot holding the ID of the given name, or the empty slot where it belongs.
+ *
+ * @param table The symbol table, which must have at least one slot.
+ * @param name The name to look up.
+ * @param hash The hash of the name.
+ * @return A pointer to the matching or empty slot.
+ */
+static int* find_slot(const SymbolTable *table, const char *name, unsigned long hash) {
+    unsigned long mask = (unsigned long) table->capacity - 1;
+    unsigned long index = hash & mask;
+    int *slot = &table->slots[index];
+
+    while (*slot != NO_SYMBOL) {
+        if (table->hashes[*slot] == hash && strcmp(table->names[*slot], name) == 0) {
+            return slot;
+        }
+        index = (index + 1) & mask;
+        slot = &table->slots[index];
+    }
+    return slot;
+}
+
+/**
+ * @brief Doubles the number of slots and names in the table and re-inserts every ID.
+ *
+ * @param table The symbol table to grow.
+ * @return True if the table was grown successfully, otherwise false.
+ */
+static bool grow_table(SymbolTable *table) {
+    int capacity = (table->capacity == 0) ? INITIAL_SYMBOL_CAPACITY : table->capacity * 2;
+    unsigned long mask = (unsigned long) capacity - 1;
+    unsigned long index;
+    int *slots;
+    char **names;
+    unsigned long *hashes;
+    int i;
+
+    slots = (int *)counted_malloc(capacity * sizeof(int));
+    names = (char **)counted_realloc(table->names, (capacity / 2) * sizeof(char *));
+    if (names != NULL) {
+        table->names = names;
+    }
+    hashes = (unsigned long *)counted_realloc(table->hashes, (capacity / 2) * sizeof(unsigned long));
+    if (hashes != NULL) {
+        table->hashes = hashes;
+    }
+    if (slots == NULL || names == NULL || hashes == NULL) {
+        fprintf(stderr, "Memory allocation error for symbol table\n");
+        free(slots);
+        return false;
+    }
+
+    /* The table is kept at most half full, so every ID has a slot */
+    for (i = 0; i < capacity; i++) {
+        slots[i] = NO_SYMBOL;
+    }
+    for (i = 0; i < table->count; i++) {
+        index = table->hashes[i] & mask;
+        while (slots[index] != NO_SYMBOL) {
+            index = (index + 1) & mask;
+        }
+        slots[index] = i;
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    table->names_capacity = capacity / 2;
+    return true;
+}
+
+/**
+ * @brief Initializes an empty symbol table.
+ *
+ * @param table Pointer to the SymbolTable to initialize.
+ * @param arena The arena that interned names are copied into.
+ */
+void init_symbol_table(SymbolTable *table, Arena *arena) {
+    table->arena = arena;
+    table->names = NULL;
+    table->hashes = NULL;
+    table->count = 0;
+    table->names_capacity = 0;
+    table->slots = NULL;
+    table->capacity = 0;
+}
+
+/**
+ * @brief Returns the ID of a name, interning it first if it has not been seen.
+ *
+ * @param table Pointer to the symbol table.
+ * @param name The name to intern.
+ * @return The ID of the name, or NO_SYMBOL if memory allocation fails.
+ */
+int intern_symbol(SymbolTable *table, const char *name) {
+    unsigned long hash = hash_string(name);
+    int *slot;
+    char *copy;
+
+    if (table->count >= table->names_capacity && !grow_table(table)) {
+        return NO_SYMBOL;
+    }
+
+    slot = find_slot(table, name, hash);
+    if (*slot != NO_SYMBOL) {
+        return *slot;
+    }
+
+    copy = arena_strdup(table->arena, name);
+    if (copy == NULL) {
+        fprintf(stderr, "Memory allocation error for symbol name\n");
+        return NO_SYMBOL;
+    }
+    table->names[table->count] = copy;
+    table->hashes[table->count] = hash;
+    *slot = table->count;
+    return table->count++;
+}
+
+/**
+ * @brief Looks up the ID of a name without interning it.
+ *
+ * @param table Pointer to the symbol table.
+ * @param name The name to look up.
+ * @return The ID of the name, or NO_SYMBOL if it has not been interned.
+ */
+int find_symbol(const SymbolTable *table, const char *name) {
+    if (table->capacity == 0) {
+        return NO_SYMBOL;
+    }
+    return *find_slot(table, name, hash_string(name));
+}
+
+/**
+ * @brief Returns the interned copy of the name of a symbol.
+ *
+ * @param table Pointer to the symbol table.
+ * @param id The ID of the symbol.
+ * @return The name, which lives as long as the table's arena.
+ */
+char* symbol_name(const SymbolTable *table, int id) {
+    return table->names[id];
+}
+
+/**
+ * @brief Frees the IDs and slots of the symbol table; the names are released with their arena.
+ *
+ * @param table Pointer to the SymbolTable to free.
+ */
+void free_symbol_table(SymbolTable *table) {
+    free(table->names);
+    free(table->hashes);
+    free(table->slots);
+    init_symbol_table(table, table->arena);
+}
@@ -3,8 +3,7 @@
 #include <string.h>
 #include <ctype.h>
 #include "utils.h"
-
-#define INITIAL_LINE_LENGTH 128
+#include "stats.h"
 
 /**
  * @brief Trims leading and trailing whitespace from a string.
@@ -39,47 +38,6 @@ char* trim_whitespace(char *str) {
     return str;
 }
 
-/**
- * @brief Reads a line of text from a file.
- *
- * This function reads characters from a file stream until a newline or EOF is encountered.
- * It dynamically resizes the buffer as needed to accommodate the line. The caller is responsible
- * for freeing the memory allocated for the line.
- *
- * @param file The file stream to read from.
- * @return A pointer to the dynamically allocated string containing the line, or NULL if EOF is reached.
- */
-char* read_line(FILE *file){
-    char *line = malloc(INITIAL_LINE_LENGTH);
-    int length = INITIAL_LINE_LENGTH;
-    int pos = 0;
-    int c;
-
-    if (!line){
-        return NULL;
-    }
-
-    while ((c = fgetc(file)) != EOF && c != '\n'){
-        if (pos >= length - 1){
-            length *= 2;
-            line = realloc(line, length);
-            if (!line){
-                return NULL;
-            }
-        }
-
-        line[pos++] = c;
-    }
-
-    if (c == EOF && pos == 0){
-        free(line);
-        return NULL;
-    }
-
-    line[pos] = '\0';
-    return line;
-}
-
 /**
  * @brief Duplicates a string by dynamically allocating memory for the copy and returning it.
  *
@@ -96,9 +54,24 @@ char* str_duplicate(const char *str) {
         return NULL;
     }
     len = strlen(str) + 1; /* Length of the source string plus null terminator. */
-    dup = malloc(len); /* Allocate memory for the duplicate. */
+    dup = counted_malloc(len); /* Allocate memory for the duplicate. */
     if (dup != NULL) {
         memcpy(dup, str, len); /* Copy the string into the new memory. */
     }
     return dup;
 }
+
+/**
+ * @brief Computes the FNV-1a hash of a string.
+ *
+ * @param str The string to hash.
+ * @return The hash of the string.
+ */
+unsigned long hash_string(const char *str) {
+    unsigned long hash = 2166136261UL;
+    while (*str != NULL_TERMINATOR) {
+        hash ^= (unsigned char) *str++;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
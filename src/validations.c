@@ -11,26 +11,15 @@
 #include "memory.h"
 #include "error.h"
 #include "constants.h"
+#include "operations.h"
 #include <string.h>
 #include <ctype.h>
 
-/* Reserved words in the assembly language */
-const char *reserved_words[] = {
-        "mov", "cmp", "add", "sub", "lea", "clr", "not", "inc",
-        "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "stop",
-        ".data", ".string", ".extern", ".intern", NULL
+/* Words other than the operation mnemonics that cannot name a macro */
+static const char *macro_keywords[] = {
+        "macr", "endmar", NULL
 };
 
-/* Array of valid command strings */
-const char* validCommands[] = {
-        "mov", "cmp", "add", "sub", "lea", "clr", "not", "inc",
-        "dec", "jmp", "bne", "red", "prn", "jsr", "rts", "stop",
-        "macr", "endmar"
-};
-
-/* Number of valid commands in the array */
-const int validCommandsCount = sizeof(validCommands) / sizeof(validCommands[0]);
-
 /**
  * @brief Checks if a label name is a reserved word.
  *
@@ -38,93 +27,55 @@ const int validCommandsCount = sizeof(validCommands) / sizeof(validCommands[0]);
  * @return true if the label name is reserved, false otherwise.
  */
 bool is_reserved_word(const char *label_name) {
-    int i;
-    for (i = 0; reserved_words[i] != NULL; i++) {
-        if (strcmp(label_name, reserved_words[i]) == 0) {
-            return true;
-        }
-    }
-    return false;
+    return find_keyword(label_name, strlen(label_name)) != NULL;
 }
 
 /**
  * @brief Validates an instruction based on its operation and addressing modes.
  *
- * Ensures that the instruction uses valid addressing modes for both source and destination operands.
+ * The operand count of the operation decides which operands must be present, and the
+ * operation's source and destination mode masks decide which addressing modes they may use.
  *
- * @param operation The operation (mnemonic) of the instruction.
+ * @param operation The operation keyword of the instruction, or NULL if the operation is unknown.
  * @param dest_mode The addressing mode of the destination operand.
  * @param source_mode The addressing mode of the source operand.
  * @param memory Pointer to the Memory structure, used for error reporting.
  * @return true if the instruction is valid, false otherwise.
  */
-bool validate_instruction(char *operation, int dest_mode, int source_mode, Memory *memory) {
+bool validate_instruction(const Keyword *operation, int dest_mode, int source_mode, Memory *memory) {
     bool success = true;
+    bool has_source;
 
-    if (strcmp(operation, "mov") == 0 || strcmp(operation, "cmp") == 0 ||
-        strcmp(operation, "add") == 0 || strcmp(operation, "sub") == 0 ||
-        strcmp(operation, "lea") == 0) {
-
-        if (source_mode == UNDEFINED_MODE) {
-            add_error(ERR_INVALID_SOURCE_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        if (dest_mode == UNDEFINED_MODE) {
-            add_error(ERR_INVALID_DEST_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        if (strcmp(operation, "cmp") != 0 && dest_mode == IMMEDIATE_MODE) {
-            add_error(ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        if (strcmp(operation, "lea") == 0) {
-            if (source_mode != DIRECT_MODE) {
-                add_error(ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
-                success = false;
-            }
-            if (dest_mode == IMMEDIATE_MODE) {
-                add_error(ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
-                success = false;
-            }
-        }
+    if (operation == NULL || operation->directive != DIRECTIVE_NONE) {
         return success;
-    } else if (strcmp(operation, "clr") == 0 || strcmp(operation, "not") == 0 ||
-               strcmp(operation, "inc") == 0 || strcmp(operation, "dec") == 0 ||
-               strcmp(operation, "jmp") == 0 || strcmp(operation, "bne") == 0 ||
-               strcmp(operation, "red") == 0 || strcmp(operation, "jsr") == 0 ||
-               strcmp(operation, "prn") == 0) {
-
-        if (source_mode != UNDEFINED_MODE) {
-            add_error(ERR_INVALID_SOURCE_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        if (dest_mode == UNDEFINED_MODE) {
-            add_error(ERR_INVALID_DEST_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        if (strcmp(operation, "prn") == 0) {
-            return success;
-        }
-        if (dest_mode == IMMEDIATE_MODE &&
-            (strcmp(operation, "clr") == 0 || strcmp(operation, "not") == 0 ||
-             strcmp(operation, "inc") == 0 || strcmp(operation, "dec") == 0 ||
-             strcmp(operation, "red") == 0)) {
-            add_error(ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        if ((strcmp(operation, "jmp") == 0 || strcmp(operation, "bne") == 0 ||
-             strcmp(operation, "jsr") == 0) && (dest_mode == IMMEDIATE_MODE || dest_mode == DIRECT_MODE)) {
-            add_error(ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
-            success = false;
-        }
-        return success;
-    } else if (strcmp(operation, "rts") == 0 || strcmp(operation, "stop") == 0) {
+    }
+
+    if (operation->operand_count == 0) {
         if (source_mode != UNDEFINED_MODE || dest_mode != UNDEFINED_MODE) {
-            add_error(ERR_INVALID_SOURCE_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
+            add_error(memory->errors, ERR_INVALID_SOURCE_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
             success = false;
         }
         return success;
     }
+
+    has_source = (operation->operand_count == 2);
+    if ((source_mode == UNDEFINED_MODE) == has_source) {
+        add_error(memory->errors, ERR_INVALID_SOURCE_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
+        success = false;
+    }
+    if (dest_mode == UNDEFINED_MODE) {
+        add_error(memory->errors, ERR_INVALID_DEST_OPERAND, memory->current_file, memory->current_line_number, memory->current_line);
+        success = false;
+    }
+
+    if (has_source && source_mode != UNDEFINED_MODE && (operation->source_modes & source_mode) == 0) {
+        add_error(memory->errors, ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
+        success = false;
+    }
+    if (dest_mode != UNDEFINED_MODE && (operation->dest_modes & dest_mode) == 0) {
+        add_error(memory->errors, ERR_INVALID_ADDRESS_MODE, memory->current_file, memory->current_line_number, memory->current_line);
+        success = false;
+    }
     return success;
 }
 
@@ -235,9 +186,9 @@ bool validate_label_declaration(char *label_name, Memory *memory) {
     if (!validate_label_name(label_name, memory)) {
         return false;
     }
-    label = find_label(memory->label_list, label_name);
+    label = find_label(&memory->labels, label_name);
     if (label != NULL && label->declared) {
-        add_error(ERR_LABEL_ALREADY_DECLARED, memory->current_file, memory->current_line_number, label_name);
+        add_error(memory->errors, ERR_LABEL_ALREADY_DECLARED, memory->current_file, memory->current_line_number, label_name);
         return false;
     }
     return true;
@@ -257,20 +208,20 @@ bool validate_label_name(char *label_name, Memory *memory) {
 
     /* Check if the label starts with a letter */
     if (!isalpha(label_name[0])) {
-        add_error(ERR_INVALID_LABEL_NAME, memory->current_file, memory->current_line_number, label_name);
+        add_error(memory->errors, ERR_INVALID_LABEL_NAME, memory->current_file, memory->current_line_number, label_name);
         return false;
     }
 
     /* Check if the label is a reserved word */
     if (is_reserved_word(label_name)) {
-        add_error(ERR_RESERVED_WORD, memory->current_file, memory->current_line_number, label_name);
+        add_error(memory->errors, ERR_RESERVED_WORD, memory->current_file, memory->current_line_number, label_name);
         return false;
     }
 
     /* Check if the label name is used as a macro */
-    macro = find_macro(label_name);
+    macro = (memory->macros != NULL) ? find_macro(memory->macros, label_name) : NULL;
     if (macro != NULL) {
-        add_error(ERR_LABEL_NAME_USED_AS_MACRO, memory->current_file, memory->current_line_number, label_name);
+        add_error(memory->errors, ERR_LABEL_NAME_USED_AS_MACRO, memory->current_file, memory->current_line_number, label_name);
         return false;
     }
 
@@ -294,8 +245,11 @@ bool validate_macro_name(char* macroName) {
     }
 
     /* Check if the macroName is not a reserved command */
-    for (i = 0; i < validCommandsCount; i++) {
-        if (strcmp(validCommands[i], macroName) == 0) {
+    if (find_keyword(macroName, strlen(macroName)) != NULL) {
+        return false;
+    }
+    for (i = 0; macro_keywords[i] != NULL; i++) {
+        if (strcmp(macro_keywords[i], macroName) == 0) {
             return false;
         }
     }